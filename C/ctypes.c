@@ -4,7 +4,52 @@
 // NOTE: you will need to use a compiler that conforms to the C99 standard
 //       in GNU GCC, you can enable this with -std=c99 (or gnu99)
 //
+//   build: gcc -std=gnu99 -O2 -o ctypes ctypes.c -pthread -lm
+//          (or make; the Makefile also builds static and minimal-startup
+//          variants, and make bench times their startup and full report)
 //
+// usage: ctypes [-bmyasdv] [--only list] [--skip list] [-l list [-n count]] [arg]
+//        ctypes -B file
+//        ctypes -D type [-r] [file]
+//        ctypes -f json|csv|binary
+//        ctypes -q key [-R]
+//   (no args)     - print the sizes of all primitive data types
+//   -b, --bench   - also measure the latency and throughput of arithmetic on
+//                   each primitive type (build with optimizations, e.g. -O2)
+//   -m, --memory  - measure load latency across working-set sizes and infer
+//                   the cache hierarchy from it
+//   -y, --copy    - measure memcpy/memmove/memset and alternative copy kernels
+//                   across buffer sizes and misalignments
+//   -a, --atomics - report lock-free atomics and measure atomic operations,
+//                   core-to-core latency and false sharing
+//   -s, --simd    - report the SIMD extensions of the CPU against those the
+//                   binary was compiled for, vector type sizes, and peak FLOPS
+//   -d, --denormal - measure the subnormal-operand penalty with and without
+//                   FTZ/DAZ, and the cost of switching rounding modes
+//   -v, --vm      - report page and huge page sizes and measure page-fault
+//                   and random-access cost with and without huge pages
+//   -l, --layout  - lay out a struct with the given comma-separated member
+//                   types (e.g. 'char,double,int,bool,uint64_t[3]') and
+//                   suggest a smaller, cache-friendlier member order
+//   -n, --count   - array length used for --layout cache-line counts
+//   -B, --bits    - dump a file ('-' for stdin) as binary, hex, octal and text
+//                   columns, like xxd -b, and nothing else
+//   -D, --decode  - read numbers of the given type (float, double, int8..int64,
+//                   uint8..uint64) one per line from file or stdin and print
+//                   their fields, %a form, bit pattern and class
+//   -r, --raw     - read --decode input as native-endian binary records
+//   -q, --query   - print one value: a constant such as DBL_EPSILON, or a
+//                   measured one such as L2_size, cpu_ghz or memcpy_gbps
+//   -R, --refresh - measure again instead of using the profile cache
+//   --only        - print just the comma-separated sections (sizes, consts,
+//                   bench, memory, copy, atomics, simd, denormal, vm)
+//   --skip        - leave out the listed sections; on its own, print all others
+//   -f, --format  - print the type sizes and constants as text (default), json,
+//                   csv or binary records instead of the report tables
+//   arg           - any other argument also prints the type-related constants
+//
+
+#define _GNU_SOURCE
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,6 +62,25 @@
 #include <float.h>
 #include <limits.h>
 #include <stddef.h>
+#include <getopt.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <fenv.h>
+#include <math.h>
+#include <locale.h>
+#include <link.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#endif
 
 #define LINE_BUFSZ 1024
 #define LINE_WIDTH 100
@@ -24,468 +88,5016 @@
 #define DVAL_WIDTH 21
 #define HVAL_WIDTH -27
 
-static const char BITCHAR[] = { '0', '1' };
+#define BENCH_UNROLL   8         // operations issued per loop iteration
+#define BENCH_MIN_NS   2.0e6     // minimum duration of a single timed run
+#define BENCH_MAX_ITER (1 << 24) // upper bound on loop iterations per run
+
+#define STATS_MIN_RUNS 5         // timed runs per measurement, at least
+#define STATS_MAX_RUNS 25        // and at most
+#define STATS_CI       0.02      // target 95% confidence half-width, relative
+
+// hides the value of x from the optimizer without emitting any instructions,
+// so that chained operations cannot be folded, hoisted, or vectorized. the
+// value is kept in the register class the type naturally lives in.
+#define OPAQUE(x) __asm__ __volatile__("" : "+r"(x))
+#if defined(__x86_64__) || defined(__SSE2_MATH__)
+#define OPAQUE_FP(x) __asm__ __volatile__("" : "+x"(x))
+#define OPAQUE_LD(x) __asm__ __volatile__("" : "+t"(x))
+#elif defined(__aarch64__)
+#define OPAQUE_FP(x) __asm__ __volatile__("" : "+w"(x))
+#define OPAQUE_LD(x) __asm__ __volatile__("" : "+w"(x))
+#else
+#define OPAQUE_FP(x) __asm__ __volatile__("" : "+m"(x))
+#define OPAQUE_LD(x) __asm__ __volatile__("" : "+m"(x))
+#endif
+
+#define DUMP_LINE_BYTES 8           // input bytes rendered per --bits line
+#define DUMP_CHUNK      (1UL << 20) // bytes per read() when input cannot be mapped
+#define DUMP_OUTBUF     (1UL << 20) // output buffer, flushed with one write()
+
+static char BINTAB[256][8]; // each byte as 8 binary digits, most significant first
+static char HEXTAB[256][2];
+static char OCTTAB[256][3];
+static char TXTTAB[256];    // printable ASCII, or '.'
 
-char *bitstr(const void *x, size_t n/*bits*/)
+// fills the digit tables once; every renderer below copies whole digit
+// groups out of them instead of shifting out one bit at a time
+void bittables()
 {
-  char *str = calloc(n + 1, sizeof(*str));
-  size_t i  = n - 1;
+  static const char DIGIT[] = "0123456789abcdef";
+  static bool       filled  = false;
+  int               b       = 0;
+  int               i       = 0;
 
-  while (n--)
-    str[i - n] = BITCHAR[(*(uint64_t *)x >> n) & 1];
+  if (filled)
+    return;
 
-  return str;
+  for (b = 0; b < 256; ++b)
+  {
+    for (i = 0; i < 8; ++i)
+      BINTAB[b][i] = DIGIT[(b >> (7 - i)) & 1];
+    HEXTAB[b][0] = DIGIT[b >> 4];
+    HEXTAB[b][1] = DIGIT[b & 15];
+    OCTTAB[b][0] = DIGIT[b >> 6];
+    OCTTAB[b][1] = DIGIT[(b >> 3) & 7];
+    OCTTAB[b][2] = DIGIT[b & 7];
+    TXTTAB[b]    = b >= 0x20 && b < 0x7f ? (char)b : '.';
+  }
+
+  filled = true;
 }
 
-char *repchar(const char c, size_t n)
+// renders the low n bits of the integer at x (n <= 64, reading only as many
+// bytes as n needs) into str, most significant bit first, and returns str.
+// str must hold n + 1 chars.
+char *bitstr(char *str, const void *x, size_t n/*bits*/)
 {
-  char *str = calloc(n + 1, sizeof(*str));
+  uint64_t v = 0;
+  char    *s = str;
 
-  while (n--)
-    str[n] = c;
+  bittables();
+
+  if (n <= 8)       { uint8_t  u; memcpy(&u, x, sizeof(u)); v = u; }
+  else if (n <= 16) { uint16_t u; memcpy(&u, x, sizeof(u)); v = u; }
+  else if (n <= 32) { uint32_t u; memcpy(&u, x, sizeof(u)); v = u; }
+  else              { uint64_t u; memcpy(&u, x, sizeof(u)); v = u; }
+
+  // a leading partial byte, then whole bytes from the table
+  for (; n % 8; --n)
+    *s++ = (char)('0' + ((v >> (n - 1)) & 1));
+  for (; n > 0; n -= 8, s += 8)
+    memcpy(s, BINTAB[(v >> (n - 8)) & 0xff], 8);
+  *s = '\0';
 
   return str;
 }
 
+// a LINE_WIDTH-wide rule of '=' or '-', built once in static storage
+const char *ruler(const char c)
+{
+  static char rule[2][LINE_WIDTH + 1];
+  char       *line = rule['=' == c ? 0 : 1];
+
+  if ('\0' == line[0])
+    memset(line, c, LINE_WIDTH);
+
+  return line;
+}
+
 void raprintf(const int width, const char *format, ...)
 {
-  char *line = calloc(width, sizeof(*line));
+  char line[LINE_BUFSZ];
 
   va_list args;
   va_start(args, format);
-  (void)vsnprintf(line, width, format, args);
+  (void)vsnprintf(line, (size_t)width < sizeof(line) ? (size_t)width : sizeof(line), format, args);
   va_end(args);
 
   printf("%*s", width, line);
+}
+
+double nanotime()
+{
+  struct timespec ts;
 
-  free(line);
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return 1.0e9 * ts.tv_sec + ts.tv_nsec;
 }
 
-void printsizes()
+// summary of the runs of one measurement
+struct stats
 {
-  char *majorline = repchar('=', LINE_WIDTH);
-  char *minorline = repchar('-', LINE_WIDTH);
+  double median;
+  double p99;
+  double cv;     // standard deviation over mean
+  size_t runs;
+};
 
-  puts(majorline);
-  printf("%*s\n", LINE_WIDTH - 2, "PRIMITIVE DATA TYPE SIZES");
-  puts(majorline);
+// measurement quality of the current section, printed by printquality()
+static struct
+{
+  size_t cells;
+  size_t minruns;
+  size_t maxruns;
+  double cvsum;
+  double cvmax;
+  double tailmax; // worst p99 over median
+} QUALITY;
 
-  putchar('\n');
-#if __bool_true_false_are_defined
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "_Bool",                  sizeof(_Bool),                  8 * sizeof(_Bool));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "bool",                   sizeof(bool),                   8 * sizeof(bool));
-#endif
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "char",                   sizeof(char),                   8 * sizeof(char));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "signed char",            sizeof(signed char),            8 * sizeof(signed char));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "unsigned char",          sizeof(unsigned char),          8 * sizeof(unsigned char));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "short",                  sizeof(short),                  8 * sizeof(short));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "short int",              sizeof(short int),              8 * sizeof(short int));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "signed short",           sizeof(signed short),           8 * sizeof(signed short));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "signed short int",       sizeof(signed short int),       8 * sizeof(signed short int));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "unsigned short",         sizeof(unsigned short),         8 * sizeof(unsigned short));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "unsigned short int",     sizeof(unsigned short int),     8 * sizeof(unsigned short int));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "int",                    sizeof(int),                    8 * sizeof(int));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "signed",                 sizeof(signed),                 8 * sizeof(signed));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "signed int",             sizeof(signed int),             8 * sizeof(signed int));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "unsigned",               sizeof(unsigned),               8 * sizeof(unsigned));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "unsigned int",           sizeof(unsigned int),           8 * sizeof(unsigned int));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "long",                   sizeof(long),                   8 * sizeof(long));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "long int",               sizeof(long int),               8 * sizeof(long int));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "signed long",            sizeof(signed long),            8 * sizeof(signed long));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "signed long int",        sizeof(signed long int),        8 * sizeof(signed long int));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "unsigned long",          sizeof(unsigned long),          8 * sizeof(unsigned long));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "unsigned long int",      sizeof(unsigned long int),      8 * sizeof(unsigned long int));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "long long",              sizeof(long long),              8 * sizeof(long long));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "long long int",          sizeof(long long int),          8 * sizeof(long long int));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "signed long long",       sizeof(signed long long),       8 * sizeof(signed long long));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "signed long long int",   sizeof(signed long long int),   8 * sizeof(signed long long int));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "unsigned long long",     sizeof(unsigned long long),     8 * sizeof(unsigned long long));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "unsigned long long int", sizeof(unsigned long long int), 8 * sizeof(unsigned long long int));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "float",                  sizeof(float),                  8 * sizeof(float));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "double",                 sizeof(double),                 8 * sizeof(double));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "long double",            sizeof(long double),            8 * sizeof(long double));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "intmax_t",               sizeof(intmax_t),               8 * sizeof(intmax_t));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "uintmax_t",              sizeof(uintmax_t),              8 * sizeof(uintmax_t));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "size_t",                 sizeof(size_t),                 8 * sizeof(size_t));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "ssize_t",                sizeof(ssize_t),                8 * sizeof(ssize_t));
-  puts(minorline);
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "intptr_t",               sizeof(intptr_t),               8 * sizeof(intptr_t));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "uintptr_t",              sizeof(uintptr_t),              8 * sizeof(uintptr_t));
-  raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", "ptrdiff_t",              sizeof(ptrdiff_t),              8 * sizeof(ptrdiff_t));
-  puts(minorline);
+int comparedouble(const void *a, const void *b)
+{
+  double x = *(const double *)a;
+  double y = *(const double *)b;
 
+  return (x > y) - (x < y);
 }
 
-void printconsts()
+// times run(arg) at least STATS_MIN_RUNS times, and then until the 95%
+// confidence interval of the mean is within STATS_CI of it or STATS_MAX_RUNS
+// is reached. the median is returned; the spread goes into st and QUALITY.
+double sample(double (*run)(void *), void *arg, struct stats *st)
 {
-  char *majorline = repchar('=', LINE_WIDTH);
-  char *minorline = repchar('-', LINE_WIDTH);
+  // two-sided 95% Student t quantiles for 4..24 degrees of freedom
+  static const double T95[] = {
+    2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145,
+    2.131, 2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+  };
 
+  double x[STATS_MAX_RUNS];
+  double sum   = 0.0;
+  double sumsq = 0.0;
+  double mean  = 0.0;
+  double sd    = 0.0;
+  size_t n     = 0;
+  struct stats local;
 
-  puts(majorline);
-  printf("%*s\n", LINE_WIDTH - 2, "TYPE-RELATED CONSTANTS");
-  puts(majorline);
+  if (NULL == st)
+    st = &local;
 
+  for (n = 0; n < STATS_MAX_RUNS; )
+  {
+    x[n]   = run(arg);
+    sum   += x[n];
+    sumsq += x[n] * x[n];
+    ++n;
 
-#if defined(CHAR_BIT)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)]\n%s\n" \
-             "\tsize of the char type in bits (at least 8 bits)\n",
-    CSYM_WIDTH, "CHAR_BIT", DVAL_WIDTH, CHAR_BIT, HVAL_WIDTH, CHAR_BIT, 8 * sizeof(CHAR_BIT),
-    minorline);
-  puts(majorline);
-#endif
+    mean = sum / n;
+    sd   = n > 1 && sumsq > sum * mean ? sqrt((sumsq - sum * mean) / (n - 1)) : 0.0;
+    if (n >= STATS_MIN_RUNS && T95[n - STATS_MIN_RUNS] * sd / sqrt((double)n) <= STATS_CI * mean)
+      break;
+  }
 
+  qsort(x, n, sizeof(*x), comparedouble);
+  st->median = n % 2 ? x[n / 2] : 0.5 * (x[n / 2 - 1] + x[n / 2]);
+  st->p99    = x[(99 * n + 99) / 100 - 1];
+  st->cv     = mean > 0.0 ? sd / mean : 0.0;
+  st->runs   = n;
 
-#if __bool_true_false_are_defined
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)] /*C99*/\n%s\n" \
-             "\tvalues of both boolean states\n",
-    CSYM_WIDTH, "true",  DVAL_WIDTH, true,  HVAL_WIDTH, true,  8 * sizeof(true),
-    CSYM_WIDTH, "false", DVAL_WIDTH, false, HVAL_WIDTH, false, 8 * sizeof(false),
-    minorline);
-  puts(majorline);
-#endif
+  if (0 == QUALITY.cells++ || n < QUALITY.minruns)
+    QUALITY.minruns = n;
+  if (n > QUALITY.maxruns)
+    QUALITY.maxruns = n;
+  QUALITY.cvsum += st->cv;
+  if (st->cv > QUALITY.cvmax)
+    QUALITY.cvmax = st->cv;
+  if (st->median > 0.0 && st->p99 / st->median > QUALITY.tailmax)
+    QUALITY.tailmax = st->p99 / st->median;
 
+  return st->median;
+}
 
-#if defined(SCHAR_MIN) && defined(SHRT_MIN) && defined(INT_MIN) && defined(LONG_MIN) && defined(LLONG_MIN)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*ld | %#*lx (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*lld | %#*llx (%3zu-bit)] /*C99*/\n%s\n" \
-             "\tminimum possible value of signed integer types: signed char, signed short, signed\n" \
-             "\tint, signed long, signed long long\n",
-    CSYM_WIDTH, "SCHAR_MIN", DVAL_WIDTH, SCHAR_MIN, HVAL_WIDTH, SCHAR_MIN, 8 * sizeof(SCHAR_MIN),
-    CSYM_WIDTH, "SHRT_MIN",  DVAL_WIDTH, SHRT_MIN,  HVAL_WIDTH, SHRT_MIN,  8 * sizeof(SHRT_MIN),
-    CSYM_WIDTH, "INT_MIN",   DVAL_WIDTH, INT_MIN,   HVAL_WIDTH, INT_MIN,   8 * sizeof(INT_MIN),
-    CSYM_WIDTH, "LONG_MIN",  DVAL_WIDTH, LONG_MIN,  HVAL_WIDTH, LONG_MIN,  8 * sizeof(LONG_MIN),
-    CSYM_WIDTH, "LLONG_MIN", DVAL_WIDTH, LLONG_MIN, HVAL_WIDTH, LLONG_MIN, 8 * sizeof(LLONG_MIN),
-    minorline);
-  puts(majorline);
-#endif
+// prints and resets the measurement quality of the section so far
+void printquality()
+{
+  if (QUALITY.cells > 0)
+  {
+    printf("\t%zu measurements, each the median of %zu..%zu runs (until the 95%% CI was within\n" \
+           "\t%.0f%% of the mean, or %d runs); CV mean %.1f%%, max %.1f%%; p99/median max %.2f\n",
+      QUALITY.cells, QUALITY.minruns, QUALITY.maxruns, 100.0 * STATS_CI, STATS_MAX_RUNS,
+      100.0 * QUALITY.cvsum / QUALITY.cells, 100.0 * QUALITY.cvmax, QUALITY.tailmax);
+  }
+  memset(&QUALITY, 0, sizeof(QUALITY));
+}
 
+#define PROFILE_VERSION  2
+#define PROFILE_NAME_LEN 32  // longest published value name, with its NUL
+#define PROFILE_KEY_LEN  512 // cpu, microcode, kernel and binary identity
+#define PROFILE_MAX      256 // values published per run
 
-#if defined(SCHAR_MAX) && defined(SHRT_MAX) && defined(INT_MAX) && defined(LONG_MAX) && defined(LLONG_MAX)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*ld | %#*lx (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*lld | %#*llx (%3zu-bit)] /*C99*/\n%s\n" \
-             "\tmaximum possible value of signed integer types: signed char, signed short, signed\n" \
-             "\tint, signed long, signed long long\n",
-    CSYM_WIDTH, "SCHAR_MAX", DVAL_WIDTH, SCHAR_MAX, HVAL_WIDTH, SCHAR_MAX, 8 * sizeof(SCHAR_MAX),
-    CSYM_WIDTH, "SHRT_MAX",  DVAL_WIDTH, SHRT_MAX,  HVAL_WIDTH, SHRT_MAX,  8 * sizeof(SHRT_MAX),
-    CSYM_WIDTH, "INT_MAX",   DVAL_WIDTH, INT_MAX,   HVAL_WIDTH, INT_MAX,   8 * sizeof(INT_MAX),
-    CSYM_WIDTH, "LONG_MAX",  DVAL_WIDTH, LONG_MAX,  HVAL_WIDTH, LONG_MAX,  8 * sizeof(LONG_MAX),
-    CSYM_WIDTH, "LLONG_MAX", DVAL_WIDTH, LLONG_MAX, HVAL_WIDTH, LLONG_MAX, 8 * sizeof(LLONG_MAX),
-    minorline);
-  puts(majorline);
-#endif
+enum
+{
+  SECTION_BENCH,
+  SECTION_MEMORY,
+  SECTION_COPY,
+  SECTION_ATOMICS,
+  SECTION_SIMD,
+  SECTION_DENORMAL,
+  SECTION_VM,
+  SECTION_COUNT,
+};
 
+// named like the options that select them
+static const char *SECTIONNAME[SECTION_COUNT] = {
+  "bench", "memory", "copy", "atomics", "simd", "denormal", "vm",
+};
 
-#if defined(UCHAR_MAX) && defined(USHRT_MAX) && defined(UINT_MAX) && defined(ULONG_MAX) && defined(ULLONG_MAX)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*u | %#*x (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*u | %#*x (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*u | %#*x (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*lu | %#*lx (%3zu-bit)] /*C99*/\n" \
-         "%*s [ %*llu | %#*llx (%3zu-bit)] /*C99*/\n%s\n" \
-             "\tmaximum possible value of unsigned integer types: unsigned char, unsigned short,\n" \
-             "\tunsigned int, unsigned long, unsigned long long\n",
-    CSYM_WIDTH, "UCHAR_MAX",  DVAL_WIDTH, UCHAR_MAX,  HVAL_WIDTH, UCHAR_MAX,  8 * sizeof(UCHAR_MAX),
-    CSYM_WIDTH, "USHRT_MAX",  DVAL_WIDTH, USHRT_MAX,  HVAL_WIDTH, USHRT_MAX,  8 * sizeof(USHRT_MAX),
-    CSYM_WIDTH, "UINT_MAX",   DVAL_WIDTH, UINT_MAX,   HVAL_WIDTH, UINT_MAX,   8 * sizeof(UINT_MAX),
-    CSYM_WIDTH, "ULONG_MAX",  DVAL_WIDTH, ULONG_MAX,  HVAL_WIDTH, ULONG_MAX,  8 * sizeof(ULONG_MAX),
-    CSYM_WIDTH, "ULLONG_MAX", DVAL_WIDTH, ULLONG_MAX, HVAL_WIDTH, ULLONG_MAX, 8 * sizeof(ULLONG_MAX),
-    minorline);
-  puts(majorline);
-#endif
+struct profilevalue
+{
+  char     name[PROFILE_NAME_LEN];
+  double   value;
+  uint32_t section;
+  uint32_t reserved;
+};
 
+// measured sections publish their headline numbers and have their report
+// text captured, and both are merged into the profile cache on exit
+static struct
+{
+  struct profilevalue  value[PROFILE_MAX];
+  size_t               values;
+  int                  section;                 // being measured
+  bool                 measured[SECTION_COUNT];
+  char                *text[SECTION_COUNT];     // captured report text
+  size_t               textlen[SECTION_COUNT];
+  FILE                *out;                     // real stdout while it is captured
+  bool                 echo;                    // pass captured text through
+  bool                 tty;
+  const unsigned char *map;                     // validated cache file, if any
+  size_t               mapsize;
+  char                 key[PROFILE_KEY_LEN];
+  char                 path[PATH_MAX];
+} PROFILE;
 
-#if defined(CHAR_MIN)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)]\n%s\n" \
-             "\tminimum possible value of char\n",
-    CSYM_WIDTH, "CHAR_MIN", DVAL_WIDTH, CHAR_MIN, HVAL_WIDTH, CHAR_MIN, 8 * sizeof(CHAR_MIN),
-    minorline);
-  puts(majorline);
-#endif
+// records a measured value under a printf-style name for the profile cache
+void publish(const double value, const char *format, ...)
+{
+  char    name[PROFILE_NAME_LEN];
+  size_t  i = 0;
+  va_list args;
 
+  va_start(args, format);
+  (void)vsnprintf(name, sizeof(name), format, args);
+  va_end(args);
 
-#if defined(CHAR_MAX)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)]\n%s\n" \
-             "\tmaximum possible value of char\n",
-    CSYM_WIDTH, "CHAR_MAX", DVAL_WIDTH, CHAR_MAX, HVAL_WIDTH, CHAR_MAX, 8 * sizeof(CHAR_MAX),
-    minorline);
-  puts(majorline);
-#endif
+  for (i = 0; i < PROFILE.values && 0 != strcmp(PROFILE.value[i].name, name); ++i)
+    ;
+  if (PROFILE_MAX == i)
+    return;
+  if (PROFILE.values == i)
+  {
+    memcpy(PROFILE.value[i].name, name, sizeof(name));
+    ++PROFILE.values;
+  }
+  PROFILE.value[i].value   = value;
+  PROFILE.value[i].section = (uint32_t)PROFILE.section;
+}
 
+enum
+{
+  FORMAT_TEXT,
+  FORMAT_JSON,
+  FORMAT_CSV,
+  FORMAT_BINARY,
+};
 
-#if defined(MB_LEN_MAX)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)]\n%s\n" \
-             "\tmaximum number of bytes in a multibyte character\n",
-    CSYM_WIDTH, "MB_LEN_MAX", DVAL_WIDTH, MB_LEN_MAX, HVAL_WIDTH, MB_LEN_MAX, 8 * sizeof(MB_LEN_MAX),
-    minorline);
-  puts(majorline);
-#endif
+static const char *FORMATNAME[] = { "text", "json", "csv", "binary" };
 
+static char OUTBUF[1 << 16]; // stdout buffer when it is not a terminal
 
-#if defined(FLT_MIN) && defined(DBL_MIN) && defined(LDBL_MIN)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %#*g | %#*a (%3zu-bit)]\n" \
-         "%*s [ %#*lg | %#*la (%3zu-bit)]\n" \
-         "%*s [ %#*Lg | %#*La (%3zu-bit)]\n%s\n" \
-             "\tminimum normalized positive value of float, double, long double respectively\n",
-    CSYM_WIDTH, "FLT_MIN",  DVAL_WIDTH, FLT_MIN,  HVAL_WIDTH, FLT_MIN,  8 * sizeof(FLT_MIN),
-    CSYM_WIDTH, "DBL_MIN",  DVAL_WIDTH, DBL_MIN,  HVAL_WIDTH, DBL_MIN,  8 * sizeof(DBL_MIN),
-    CSYM_WIDTH, "LDBL_MIN", DVAL_WIDTH, LDBL_MIN, HVAL_WIDTH, LDBL_MIN, 8 * sizeof(LDBL_MIN),
-    minorline);
-  puts(majorline);
+struct ctype
+{
+  const char *name;
+  size_t      size;
+  int         group; // consecutive types of one group share a ruled block
+};
+
+#define CTYPE(T, group) { #T, sizeof(T), group }
+
+static const struct ctype CTYPES[] = {
+#if __bool_true_false_are_defined
+  CTYPE(_Bool,                  0),
+  CTYPE(bool,                   0),
 #endif
+  CTYPE(char,                   1),
+  CTYPE(signed char,            1),
+  CTYPE(unsigned char,          1),
+  CTYPE(short,                  2),
+  CTYPE(short int,              2),
+  CTYPE(signed short,           2),
+  CTYPE(signed short int,       2),
+  CTYPE(unsigned short,         3),
+  CTYPE(unsigned short int,     3),
+  CTYPE(int,                    4),
+  CTYPE(signed,                 4),
+  CTYPE(signed int,             4),
+  CTYPE(unsigned,               5),
+  CTYPE(unsigned int,           5),
+  CTYPE(long,                   6),
+  CTYPE(long int,               6),
+  CTYPE(signed long,            6),
+  CTYPE(signed long int,        6),
+  CTYPE(unsigned long,          7),
+  CTYPE(unsigned long int,      7),
+  CTYPE(long long,              8),
+  CTYPE(long long int,          8),
+  CTYPE(signed long long,       8),
+  CTYPE(signed long long int,   8),
+  CTYPE(unsigned long long,     9),
+  CTYPE(unsigned long long int, 9),
+  CTYPE(float,                  10),
+  CTYPE(double,                 11),
+  CTYPE(long double,            11),
+  CTYPE(intmax_t,               12),
+  CTYPE(uintmax_t,              12),
+  CTYPE(size_t,                 13),
+  CTYPE(ssize_t,                13),
+  CTYPE(intptr_t,               14),
+  CTYPE(uintptr_t,              14),
+  CTYPE(ptrdiff_t,              14),
+};
 
+enum
+{
+  CONST_INT,
+  CONST_UINT,
+  CONST_DOUBLE, // float constants are promoted to double, as printf does
+  CONST_LDOUBLE,
+};
+
+static const char *CONSTKIND[] = { "int", "uint", "double", "long double" };
+
+struct cconst
+{
+  const char *name;
+  int         kind;
+  size_t      size;         // of the constant's own type
+  intmax_t    i;
+  uintmax_t   u;
+  double      d;
+  long double ld;
+  intmax_t  (*get)(void);   // for values that can change at run time
+  const char *std;          // revision that introduced it, after C89
+  const char *note;         // shared by, and printed after, each group
+};
+
+#define CONST_I(sym, rev, text)  { .name = #sym, .kind = CONST_INT,     .size = sizeof(sym), .i  = (sym), .std = (rev), .note = (text) }
+#define CONST_U(sym, rev, text)  { .name = #sym, .kind = CONST_UINT,    .size = sizeof(sym), .u  = (sym), .std = (rev), .note = (text) }
+#define CONST_D(sym, rev, text)  { .name = #sym, .kind = CONST_DOUBLE,  .size = sizeof(sym), .d  = (sym), .std = (rev), .note = (text) }
+#define CONST_LD(sym, rev, text) { .name = #sym, .kind = CONST_LDOUBLE, .size = sizeof(sym), .ld = (sym), .std = (rev), .note = (text) }
+
+// FLT_ROUNDS follows fesetround(), so it is read when printed
+intmax_t fltrounds()
+{
+  return FLT_ROUNDS;
+}
 
+static const char NOTE_CHAR_BIT[] =
+  "\tsize of the char type in bits (at least 8 bits)\n";
+static const char NOTE_BOOL[] =
+  "\tvalues of both boolean states\n";
+static const char NOTE_SMIN[] =
+  "\tminimum possible value of signed integer types: signed char, signed short, signed\n"
+  "\tint, signed long, signed long long\n";
+static const char NOTE_SMAX[] =
+  "\tmaximum possible value of signed integer types: signed char, signed short, signed\n"
+  "\tint, signed long, signed long long\n";
+static const char NOTE_UMAX[] =
+  "\tmaximum possible value of unsigned integer types: unsigned char, unsigned short,\n"
+  "\tunsigned int, unsigned long, unsigned long long\n";
+static const char NOTE_CHAR_MIN[] =
+  "\tminimum possible value of char\n";
+static const char NOTE_CHAR_MAX[] =
+  "\tmaximum possible value of char\n";
+static const char NOTE_MB_LEN_MAX[] =
+  "\tmaximum number of bytes in a multibyte character\n";
+static const char NOTE_FMIN[] =
+  "\tminimum normalized positive value of float, double, long double respectively\n";
 #if defined(FLT_TRUE_MIN) && defined(DBL_TRUE_MIN) && defined(LDBL_TRUE_MIN)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %#*g | %#*a (%3zu-bit)] /*C11*/\n" \
-         "%*s [ %#*lg | %#*la (%3zu-bit)] /*C11*/\n" \
-         "%*s [ %#*Lg | %#*La (%3zu-bit)] /*C11*/\n%s\n" \
-             "\tminimum positive value of float, double, long double respectively\n",
-    CSYM_WIDTH, "FLT_TRUE_MIN",  DVAL_WIDTH, FLT_TRUE_MIN,  HVAL_WIDTH, FLT_TRUE_MIN,  8 * sizeof(FLT_TRUE_MIN),
-    CSYM_WIDTH, "DBL_TRUE_MIN",  DVAL_WIDTH, DBL_TRUE_MIN,  HVAL_WIDTH, DBL_TRUE_MIN,  8 * sizeof(DBL_TRUE_MIN),
-    CSYM_WIDTH, "LDBL_TRUE_MIN", DVAL_WIDTH, LDBL_TRUE_MIN, HVAL_WIDTH, LDBL_TRUE_MIN, 8 * sizeof(LDBL_TRUE_MIN),
-    minorline);
-  puts(majorline);
+static const char NOTE_FTRUE_MIN[] =
+  "\tminimum positive value of float, double, long double respectively\n";
 #endif
+static const char NOTE_FMAX[] =
+  "\tmaximum finite value of float, double, long double, respectively\n";
+static const char NOTE_FLT_ROUNDS[] =
+  "\trounding mode for floating-point operations (see: fesetround(int), fegetround(void)):\n"
+  "\t                   -1 | the default rounding direction is not known\n"
+  "\t                    0 | toward zero, FE_TOWARDZERO\n"
+  "\t                    1 | to nearest, FE_TONEAREST\n"
+  "\t                    2 | towards positive infinity, FE_UPWARD\n"
+  "\t                    3 | towards negative infinity, FE_DOWNWARD\n"
+  "\t                other | implementation-defined behavior\n";
+static const char NOTE_FLT_EVAL_METHOD[] =
+  "\tevaluation method of expressions involving different floating-point types:\n";
+static const char NOTE_FLT_RADIX[] =
+  "\tradix of the exponent in the floating-point types\n";
+static const char NOTE_FDIG[] =
+  "\tnumber of decimal digits that can be represented without losing precision by float,\n"
+  "\tdouble, long double, respectively\n";
+static const char NOTE_FEPSILON[] =
+  "\tdifference between 1.0 and the next representable value of float, double, long\n"
+  "\tdouble, respectively\n";
+static const char NOTE_FMANT_DIG[] =
+  "\tnumber of FLT_RADIX-base digits in the floating-point significand for types float,\n"
+  "\tdouble, long double, respectively\n";
+static const char NOTE_FMIN_EXP[] =
+  "\tminimum negative integer such that FLT_RADIX raised to a power one less than that\n"
+  "\tnumber is a normalized float, double, long double, respectively\n";
+static const char NOTE_FMIN_10_EXP[] =
+  "\tminimum negative integer such that 10 raised to that power is a normalized float,\n"
+  "\tdouble, long double, respectively\n";
+static const char NOTE_FMAX_EXP[] =
+  "\tmaximum positive integer such that FLT_RADIX raised to a power one less than that\n"
+  "\tnumber is a normalized float, double, long double, respectively\n";
+static const char NOTE_FMAX_10_EXP[] =
+  "\tmaximum positive integer such that 10 raised to that power is a normalized float,\n"
+  "\tdouble, long double, respectively\n";
+static const char NOTE_DECIMAL_DIG[] =
+  "\tminimum number of decimal digits such that any number of the widest supported\n"
+  "\tfloating-point type can be represented in decimal with a precision of DECIMAL_DIG\n"
+  "\tdigits and read back in the original floating-point type without changing its value.\n"
+  "\tDECIMAL_DIG is at least 10.\n";
 
-
+static const struct cconst CCONSTS[] = {
+#if defined(CHAR_BIT)
+  CONST_I(CHAR_BIT,        NULL,  NOTE_CHAR_BIT),
+#endif
+#if __bool_true_false_are_defined
+  CONST_I(true,            "C99", NOTE_BOOL),
+  CONST_I(false,           "C99", NOTE_BOOL),
+#endif
+#if defined(SCHAR_MIN) && defined(SHRT_MIN) && defined(INT_MIN) && defined(LONG_MIN) && defined(LLONG_MIN)
+  CONST_I(SCHAR_MIN,       "C99", NOTE_SMIN),
+  CONST_I(SHRT_MIN,        "C99", NOTE_SMIN),
+  CONST_I(INT_MIN,         "C99", NOTE_SMIN),
+  CONST_I(LONG_MIN,        "C99", NOTE_SMIN),
+  CONST_I(LLONG_MIN,       "C99", NOTE_SMIN),
+#endif
+#if defined(SCHAR_MAX) && defined(SHRT_MAX) && defined(INT_MAX) && defined(LONG_MAX) && defined(LLONG_MAX)
+  CONST_I(SCHAR_MAX,       "C99", NOTE_SMAX),
+  CONST_I(SHRT_MAX,        "C99", NOTE_SMAX),
+  CONST_I(INT_MAX,         "C99", NOTE_SMAX),
+  CONST_I(LONG_MAX,        "C99", NOTE_SMAX),
+  CONST_I(LLONG_MAX,       "C99", NOTE_SMAX),
+#endif
+#if defined(UCHAR_MAX) && defined(USHRT_MAX) && defined(UINT_MAX) && defined(ULONG_MAX) && defined(ULLONG_MAX)
+  CONST_U(UCHAR_MAX,       "C99", NOTE_UMAX),
+  CONST_U(USHRT_MAX,       "C99", NOTE_UMAX),
+  CONST_U(UINT_MAX,        "C99", NOTE_UMAX),
+  CONST_U(ULONG_MAX,       "C99", NOTE_UMAX),
+  CONST_U(ULLONG_MAX,      "C99", NOTE_UMAX),
+#endif
+#if defined(CHAR_MIN)
+  CONST_I(CHAR_MIN,        NULL,  NOTE_CHAR_MIN),
+#endif
+#if defined(CHAR_MAX)
+  CONST_I(CHAR_MAX,        NULL,  NOTE_CHAR_MAX),
+#endif
+#if defined(MB_LEN_MAX)
+  CONST_I(MB_LEN_MAX,      NULL,  NOTE_MB_LEN_MAX),
+#endif
+#if defined(FLT_MIN) && defined(DBL_MIN) && defined(LDBL_MIN)
+  CONST_D(FLT_MIN,         NULL,  NOTE_FMIN),
+  CONST_D(DBL_MIN,         NULL,  NOTE_FMIN),
+  CONST_LD(LDBL_MIN,       NULL,  NOTE_FMIN),
+#endif
+#if defined(FLT_TRUE_MIN) && defined(DBL_TRUE_MIN) && defined(LDBL_TRUE_MIN)
+  CONST_D(FLT_TRUE_MIN,    "C11", NOTE_FTRUE_MIN),
+  CONST_D(DBL_TRUE_MIN,    "C11", NOTE_FTRUE_MIN),
+  CONST_LD(LDBL_TRUE_MIN,  "C11", NOTE_FTRUE_MIN),
+#endif
 #if defined(FLT_MAX) && defined(DBL_MAX) && defined(LDBL_MAX)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %#*g | %#*a (%3zu-bit)]\n" \
-         "%*s [ %#*lg | %#*la (%3zu-bit)]\n" \
-         "%*s [ %#*Lg | %#*La (%3zu-bit)]\n%s\n" \
-             "\tmaximum finite value of float, double, long double, respectively\n",
-    CSYM_WIDTH, "FLT_MAX",  DVAL_WIDTH, FLT_MAX,  HVAL_WIDTH, FLT_MAX,  8 * sizeof(FLT_MAX),
-    CSYM_WIDTH, "DBL_MAX",  DVAL_WIDTH, DBL_MAX,  HVAL_WIDTH, DBL_MAX,  8 * sizeof(DBL_MAX),
-    CSYM_WIDTH, "LDBL_MAX", DVAL_WIDTH, LDBL_MAX, HVAL_WIDTH, LDBL_MAX, 8 * sizeof(LDBL_MAX),
-    minorline);
-  puts(majorline);
+  CONST_D(FLT_MAX,         NULL,  NOTE_FMAX),
+  CONST_D(DBL_MAX,         NULL,  NOTE_FMAX),
+  CONST_LD(LDBL_MAX,       NULL,  NOTE_FMAX),
 #endif
-
-
 #if defined(FLT_ROUNDS)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)]\n%s\n" \
-             "\trounding mode for floating-point operations (see: fesetround(int), fegetround(void)):\n"
-             "\t%*d | the default rounding direction is not known\n" \
-             "\t%*d | toward zero, FE_TOWARDZERO\n" \
-             "\t%*d | to nearest, FE_TONEAREST\n" \
-             "\t%*d | towards positive infinity, FE_UPWARD\n" \
-             "\t%*d | towards negative infinity, FE_DOWNWARD\n" \
-             "\t%*s | implementation-defined behavior\n",
-    CSYM_WIDTH, "FLT_ROUNDS", DVAL_WIDTH, FLT_ROUNDS, HVAL_WIDTH, FLT_ROUNDS, 8 * sizeof(FLT_ROUNDS),
-    minorline,
-    DVAL_WIDTH, -1,
-    DVAL_WIDTH,  0,
-    DVAL_WIDTH,  1,
-    DVAL_WIDTH,  2,
-    DVAL_WIDTH,  3,
-    DVAL_WIDTH, "other");
-  puts(majorline);
+  { .name = "FLT_ROUNDS", .kind = CONST_INT, .size = sizeof(FLT_ROUNDS), .get = fltrounds, .note = NOTE_FLT_ROUNDS },
 #endif
-
-
 #if defined(FLT_EVAL_METHOD)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)] /*C99*/\n%s\n" \
-             "\tevaluation method of expressions involving different floating-point types:\n",
-    CSYM_WIDTH, "FLT_EVAL_METHOD", DVAL_WIDTH, FLT_EVAL_METHOD, HVAL_WIDTH, FLT_EVAL_METHOD, 8 * sizeof(FLT_EVAL_METHOD),
-    minorline);
-  puts(majorline);
+  CONST_I(FLT_EVAL_METHOD, "C99", NOTE_FLT_EVAL_METHOD),
 #endif
-
-
 #if defined(FLT_RADIX)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)]\n%s\n" \
-             "\tradix of the exponent in the floating-point types\n",
-    CSYM_WIDTH, "FLT_RADIX", DVAL_WIDTH, FLT_RADIX, HVAL_WIDTH, FLT_RADIX, 8 * sizeof(FLT_RADIX),
-    minorline);
-  puts(majorline);
+  CONST_I(FLT_RADIX,       NULL,  NOTE_FLT_RADIX),
 #endif
-
-
 #if defined(FLT_DIG) && defined(DBL_DIG) && defined(LDBL_DIG)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)]\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)]\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)]\n%s\n" \
-             "\tnumber of decimal digits that can be represented without losing precision by float,\n" \
-             "\tdouble, long double, respectively\n",
-    CSYM_WIDTH, "FLT_DIG",  DVAL_WIDTH, FLT_DIG,  HVAL_WIDTH, FLT_DIG,  8 * sizeof(FLT_DIG),
-    CSYM_WIDTH, "DBL_DIG",  DVAL_WIDTH, DBL_DIG,  HVAL_WIDTH, DBL_DIG,  8 * sizeof(DBL_DIG),
-    CSYM_WIDTH, "LDBL_DIG", DVAL_WIDTH, LDBL_DIG, HVAL_WIDTH, LDBL_DIG, 8 * sizeof(LDBL_DIG),
-    minorline);
-  puts(majorline);
+  CONST_I(FLT_DIG,         NULL,  NOTE_FDIG),
+  CONST_I(DBL_DIG,         NULL,  NOTE_FDIG),
+  CONST_I(LDBL_DIG,        NULL,  NOTE_FDIG),
 #endif
-
-
 #if defined(FLT_EPSILON) && defined(DBL_EPSILON) && defined(LDBL_EPSILON)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %#*g | %#*a (%3zu-bit)]\n" \
-         "%*s [ %#*lg | %#*la (%3zu-bit)]\n" \
-         "%*s [ %#*Lg | %#*La (%3zu-bit)]\n%s\n" \
-             "\tdifference between 1.0 and the next representable value of float, double, long\n" \
-             "\tdouble, respectively\n",
-    CSYM_WIDTH, "FLT_EPSILON",  DVAL_WIDTH, FLT_EPSILON,  HVAL_WIDTH, FLT_EPSILON,  8 * sizeof(FLT_EPSILON),
-    CSYM_WIDTH, "DBL_EPSILON",  DVAL_WIDTH, DBL_EPSILON,  HVAL_WIDTH, DBL_EPSILON,  8 * sizeof(DBL_EPSILON),
-    CSYM_WIDTH, "LDBL_EPSILON", DVAL_WIDTH, LDBL_EPSILON, HVAL_WIDTH, LDBL_EPSILON, 8 * sizeof(LDBL_EPSILON),
-    minorline);
-  puts(majorline);
+  CONST_D(FLT_EPSILON,     NULL,  NOTE_FEPSILON),
+  CONST_D(DBL_EPSILON,     NULL,  NOTE_FEPSILON),
+  CONST_LD(LDBL_EPSILON,   NULL,  NOTE_FEPSILON),
 #endif
-
-
 #if defined(FLT_MANT_DIG) && defined(DBL_MANT_DIG) && defined(LDBL_MANT_DIG)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)]\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)]\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)]\n%s\n" \
-             "\tnumber of FLT_RADIX-base digits in the floating-point significand for types float,\n" \
-             "\tdouble, long double, respectively\n",
-    CSYM_WIDTH, "FLT_MANT_DIG",  DVAL_WIDTH, FLT_MANT_DIG,  HVAL_WIDTH, FLT_MANT_DIG,  8 * sizeof(FLT_MANT_DIG),
-    CSYM_WIDTH, "DBL_MANT_DIG",  DVAL_WIDTH, DBL_MANT_DIG,  HVAL_WIDTH, DBL_MANT_DIG,  8 * sizeof(DBL_MANT_DIG),
-    CSYM_WIDTH, "LDBL_MANT_DIG", DVAL_WIDTH, LDBL_MANT_DIG, HVAL_WIDTH, LDBL_MANT_DIG, 8 * sizeof(LDBL_MANT_DIG),
-    minorline);
-  puts(majorline);
+  CONST_I(FLT_MANT_DIG,    NULL,  NOTE_FMANT_DIG),
+  CONST_I(DBL_MANT_DIG,    NULL,  NOTE_FMANT_DIG),
+  CONST_I(LDBL_MANT_DIG,   NULL,  NOTE_FMANT_DIG),
 #endif
-
-
 #if defined(FLT_MIN_EXP) && defined(DBL_MIN_EXP) && defined(LDBL_MIN_EXP)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)]\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)]\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)]\n%s\n" \
-             "\tminimum negative integer such that FLT_RADIX raised to a power one less than that\n" \
-             "\tnumber is a normalized float, double, long double, respectively\n",
-    CSYM_WIDTH, "FLT_MIN_EXP",  DVAL_WIDTH, FLT_MIN_EXP,  HVAL_WIDTH, FLT_MIN_EXP,  8 * sizeof(FLT_MIN_EXP),
-    CSYM_WIDTH, "DBL_MIN_EXP",  DVAL_WIDTH, DBL_MIN_EXP,  HVAL_WIDTH, DBL_MIN_EXP,  8 * sizeof(DBL_MIN_EXP),
-    CSYM_WIDTH, "LDBL_MIN_EXP", DVAL_WIDTH, LDBL_MIN_EXP, HVAL_WIDTH, LDBL_MIN_EXP, 8 * sizeof(LDBL_MIN_EXP),
-    minorline);
-  puts(majorline);
+  CONST_I(FLT_MIN_EXP,     NULL,  NOTE_FMIN_EXP),
+  CONST_I(DBL_MIN_EXP,     NULL,  NOTE_FMIN_EXP),
+  CONST_I(LDBL_MIN_EXP,    NULL,  NOTE_FMIN_EXP),
 #endif
-
-
 #if defined(FLT_MIN_10_EXP) && defined(DBL_MIN_10_EXP) && defined(LDBL_MIN_10_EXP)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)]\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)]\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)]\n%s\n" \
-             "\tminimum negative integer such that 10 raised to that power is a normalized float,\n" \
-             "\tdouble, long double, respectively\n",
-    CSYM_WIDTH, "FLT_MIN_10_EXP",  DVAL_WIDTH, FLT_MIN_10_EXP,  HVAL_WIDTH, FLT_MIN_10_EXP,  8 * sizeof(FLT_MIN_10_EXP),
-    CSYM_WIDTH, "DBL_MIN_10_EXP",  DVAL_WIDTH, DBL_MIN_10_EXP,  HVAL_WIDTH, DBL_MIN_10_EXP,  8 * sizeof(DBL_MIN_10_EXP),
-    CSYM_WIDTH, "LDBL_MIN_10_EXP", DVAL_WIDTH, LDBL_MIN_10_EXP, HVAL_WIDTH, LDBL_MIN_10_EXP, 8 * sizeof(LDBL_MIN_10_EXP),
-    minorline);
-  puts(majorline);
+  CONST_I(FLT_MIN_10_EXP,  NULL,  NOTE_FMIN_10_EXP),
+  CONST_I(DBL_MIN_10_EXP,  NULL,  NOTE_FMIN_10_EXP),
+  CONST_I(LDBL_MIN_10_EXP, NULL,  NOTE_FMIN_10_EXP),
 #endif
-
-
 #if defined(FLT_MAX_EXP) && defined(DBL_MAX_EXP) && defined(LDBL_MAX_EXP)
-  putchar('\n');
-  puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)]\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)]\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)]\n%s\n" \
-             "\tmaximum positive integer such that FLT_RADIX raised to a power one less than that\n" \
-             "\tnumber is a normalized float, double, long double, respectively\n",
-    CSYM_WIDTH, "FLT_MAX_EXP",  DVAL_WIDTH, FLT_MAX_EXP,  HVAL_WIDTH, FLT_MAX_EXP,  8 * sizeof(FLT_MAX_EXP),
-    CSYM_WIDTH, "DBL_MAX_EXP",  DVAL_WIDTH, DBL_MAX_EXP,  HVAL_WIDTH, DBL_MAX_EXP,  8 * sizeof(DBL_MAX_EXP),
-    CSYM_WIDTH, "LDBL_MAX_EXP", DVAL_WIDTH, LDBL_MAX_EXP, HVAL_WIDTH, LDBL_MAX_EXP, 8 * sizeof(LDBL_MAX_EXP),
-    minorline);
-  puts(majorline);
+  CONST_I(FLT_MAX_EXP,     NULL,  NOTE_FMAX_EXP),
+  CONST_I(DBL_MAX_EXP,     NULL,  NOTE_FMAX_EXP),
+  CONST_I(LDBL_MAX_EXP,    NULL,  NOTE_FMAX_EXP),
 #endif
+#if defined(FLT_MAX_10_EXP) && defined(DBL_MAX_10_EXP) && defined(LDBL_MAX_10_EXP)
+  CONST_I(FLT_MAX_10_EXP,  NULL,  NOTE_FMAX_10_EXP),
+  CONST_I(DBL_MAX_10_EXP,  NULL,  NOTE_FMAX_10_EXP),
+  CONST_I(LDBL_MAX_10_EXP, NULL,  NOTE_FMAX_10_EXP),
+#endif
+#if defined(DECIMAL_DIG)
+  CONST_I(DECIMAL_DIG,     "C99", NOTE_DECIMAL_DIG),
+#endif
+};
 
+#define CTYPE_COUNT  (sizeof(CTYPES) / sizeof(*CTYPES))
+#define CCONST_COUNT (sizeof(CCONSTS) / sizeof(*CCONSTS))
+
+// the integer value of a constant, or its bits truncated to its own type
+intmax_t constint(const struct cconst *c)
+{
+  return NULL != c->get ? c->get() : c->i;
+}
+
+uintmax_t constbits(const struct cconst *c)
+{
+  uintmax_t v = CONST_UINT == c->kind ? c->u : (uintmax_t)constint(c);
+
+  return c->size < sizeof(v) ? v & ((UINTMAX_C(1) << 8 * c->size) - 1) : v;
+}
+
+void printsizes()
+{
+  const char *majorline = ruler('=');
+  const char *minorline = ruler('-');
+  size_t      i         = 0;
 
-#if defined(FLT_MAX_10_EXP) && defined(DBL_MAX_10_EXP) && defined(LDBL_MAX_10_EXP)
-  putchar('\n');
   puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)]\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)]\n" \
-         "%*s [ %*d | %#*x (%3zu-bit)]\n%s\n" \
-             "\tmaximum positive integer such that 10 raised to that power is a normalized float,\n" \
-             "\tdouble, long double, respectively\n",
-    CSYM_WIDTH, "FLT_MAX_10_EXP",  DVAL_WIDTH, FLT_MAX_10_EXP,  HVAL_WIDTH, FLT_MAX_10_EXP,  8 * sizeof(FLT_MAX_10_EXP),
-    CSYM_WIDTH, "DBL_MAX_10_EXP",  DVAL_WIDTH, DBL_MAX_10_EXP,  HVAL_WIDTH, DBL_MAX_10_EXP,  8 * sizeof(DBL_MAX_10_EXP),
-    CSYM_WIDTH, "LDBL_MAX_10_EXP", DVAL_WIDTH, LDBL_MAX_10_EXP, HVAL_WIDTH, LDBL_MAX_10_EXP, 8 * sizeof(LDBL_MAX_10_EXP),
-    minorline);
+  printf("%*s\n", LINE_WIDTH - 2, "PRIMITIVE DATA TYPE SIZES");
   puts(majorline);
-#endif
 
-
-#if defined(DECIMAL_DIG)
   putchar('\n');
+  for (i = 0; i < CTYPE_COUNT; ++i)
+  {
+    if (0 == i || CTYPES[i].group != CTYPES[i - 1].group)
+      puts(minorline);
+    raprintf(LINE_WIDTH, "%s: %2zu bytes (%3zu bits)\n", CTYPES[i].name, CTYPES[i].size, 8 * CTYPES[i].size);
+  }
+  puts(minorline);
+}
+
+void printconsts()
+{
+  const char          *majorline = ruler('=');
+  const char          *minorline = ruler('-');
+  const struct cconst *c         = NULL;
+  size_t               i         = 0;
+
   puts(majorline);
-  printf("%*s [ %*d | %#*x (%3zu-bit)] /*C99*/\n%s\n" \
-             "\tminimum number of decimal digits such that any number of the widest supported\n" \
-             "\tfloating-point type can be represented in decimal with a precision of DECIMAL_DIG\n" \
-             "\tdigits and read back in the original floating-point type without changing its value.\n" \
-             "\tDECIMAL_DIG is at least 10.\n",
-    CSYM_WIDTH, "DECIMAL_DIG", DVAL_WIDTH, DECIMAL_DIG, HVAL_WIDTH, DECIMAL_DIG, 8 * sizeof(DECIMAL_DIG),
-    minorline);
+  printf("%*s\n", LINE_WIDTH - 2, "TYPE-RELATED CONSTANTS");
   puts(majorline);
-#endif
 
+  for (i = 0; i < CCONST_COUNT; ++i)
+  {
+    c = &CCONSTS[i];
+    if (0 == i || c->note != CCONSTS[i - 1].note)
+    {
+      putchar('\n');
+      puts(majorline);
+    }
+
+    switch (c->kind)
+    {
+      case CONST_INT:
+        printf("%*s [ %*jd | %#*jx (%3zu-bit)]", CSYM_WIDTH, c->name, DVAL_WIDTH, constint(c), HVAL_WIDTH, constbits(c), 8 * c->size);
+        break;
+      case CONST_UINT:
+        printf("%*s [ %*ju | %#*jx (%3zu-bit)]", CSYM_WIDTH, c->name, DVAL_WIDTH, c->u, HVAL_WIDTH, constbits(c), 8 * c->size);
+        break;
+      case CONST_DOUBLE:
+        printf("%*s [ %#*g | %#*a (%3zu-bit)]", CSYM_WIDTH, c->name, DVAL_WIDTH, c->d, HVAL_WIDTH, c->d, 8 * c->size);
+        break;
+      case CONST_LDOUBLE:
+        printf("%*s [ %#*Lg | %#*La (%3zu-bit)]", CSYM_WIDTH, c->name, DVAL_WIDTH, c->ld, HVAL_WIDTH, c->ld, 8 * c->size);
+        break;
+    }
+    if (NULL != c->std)
+      printf(" /*%s*/", c->std);
+    putchar('\n');
+
+    if (i + 1 == CCONST_COUNT || c->note != CCONSTS[i + 1].note)
+    {
+      puts(minorline);
+      fputs(c->note, stdout);
+      puts(majorline);
+    }
+  }
 
   putchar('\n');
 }
 
-int main(int argc, char *argv[])
+// writes a constant's value as a JSON or CSV number, then sep and its hex
+// form unless sep is NULL
+void printconstvalue(const struct cconst *c, const char *sep, const char *quote)
+{
+  if (NULL == sep)
+  {
+    if (CONST_LDOUBLE == c->kind)
+      printf("%.*Lg", DECIMAL_DIG, c->ld);
+    else if (CONST_DOUBLE == c->kind)
+      printf("%.17g", c->d);
+    else if (CONST_UINT == c->kind)
+      printf("%ju", c->u);
+    else
+      printf("%jd", constint(c));
+    return;
+  }
+
+  switch (c->kind)
+  {
+    case CONST_INT:
+      printf("%jd%s%s%#jx%s", constint(c), sep, quote, constbits(c), quote);
+      break;
+    case CONST_UINT:
+      printf("%ju%s%s%#jx%s", c->u, sep, quote, constbits(c), quote);
+      break;
+    case CONST_DOUBLE:
+      // 17 significant digits round-trip any double (DBL_DECIMAL_DIG, C11)
+      printf("%.17g%s%s%a%s", c->d, sep, quote, c->d, quote);
+      break;
+    case CONST_LDOUBLE:
+      printf("%.*Lg%s%s%La%s", DECIMAL_DIG, c->ld, sep, quote, c->ld, quote);
+      break;
+  }
+}
+
+// appends a native-endian field to a binary record
+unsigned char *putfield(unsigned char *out, const void *x, const size_t n)
+{
+  memcpy(out, x, n);
+  return out + n;
+}
+
+// emits the type and constant registry in a machine-readable format:
+//   json:   {"types": [...], "constants": [...]}, one record per line
+//   csv:    record,name,size,bits,kind,value,hex,std
+//   binary: an 8-byte header ("CTYP", version 1, byte order 'l' or 'B',
+//           uint16 record count) and per record: uint8 kind (0xff for a type,
+//           else the CONST_* kind), uint8 size, uint8 name length, the name,
+//           then for constants the value as int64, uint64 or double (8 bytes),
+//           or as long double (16 bytes, zero-padded); all native-endian
+void printregistry(const int format)
 {
-  printsizes();
+  const struct cconst *c      = NULL;
+  const uint16_t       order  = 0x0102;
+  unsigned char        rec[UCHAR_MAX + 64];
+  unsigned char       *out    = NULL;
+  uint16_t             count  = (uint16_t)(CTYPE_COUNT + CCONST_COUNT);
+  intmax_t             iv     = 0;
+  long double          ld     = 0.0L;
+  size_t               i      = 0;
+
+  switch (format)
+  {
+    case FORMAT_JSON:
+      printf("{\"types\": [\n");
+      for (i = 0; i < CTYPE_COUNT; ++i)
+        printf("  {\"name\": \"%s\", \"size\": %zu, \"bits\": %zu}%s\n",
+          CTYPES[i].name, CTYPES[i].size, 8 * CTYPES[i].size, i + 1 < CTYPE_COUNT ? "," : "");
+      printf("], \"constants\": [\n");
+      for (i = 0; i < CCONST_COUNT; ++i)
+      {
+        c = &CCONSTS[i];
+        printf("  {\"name\": \"%s\", \"kind\": \"%s\", \"size\": %zu, \"bits\": %zu, \"value\": ",
+          c->name, CONSTKIND[c->kind], c->size, 8 * c->size);
+        printconstvalue(c, ", \"hex\": ", "\"");
+        printf(", \"std\": %s%s%s}%s\n", c->std ? "\"" : "", c->std ? c->std : "null", c->std ? "\"" : "",
+          i + 1 < CCONST_COUNT ? "," : "");
+      }
+      printf("]}\n");
+      break;
+
+    case FORMAT_CSV:
+      printf("record,name,size,bits,kind,value,hex,std\n");
+      for (i = 0; i < CTYPE_COUNT; ++i)
+        printf("type,%s,%zu,%zu,,,,\n", CTYPES[i].name, CTYPES[i].size, 8 * CTYPES[i].size);
+      for (i = 0; i < CCONST_COUNT; ++i)
+      {
+        c = &CCONSTS[i];
+        printf("constant,%s,%zu,%zu,%s,", c->name, c->size, 8 * c->size, CONSTKIND[c->kind]);
+        printconstvalue(c, ",", "");
+        printf(",%s\n", c->std ? c->std : "");
+      }
+      break;
+
+    case FORMAT_BINARY:
+      memcpy(rec, "CTYP", 4);
+      rec[4] = 1;
+      rec[5] = 0x02 == *(const unsigned char *)&order ? 'l' : 'B';
+      memcpy(rec + 6, &count, sizeof(count));
+      fwrite(rec, 1, 8, stdout);
+      for (i = 0; i < CTYPE_COUNT + CCONST_COUNT; ++i)
+      {
+        c      = i < CTYPE_COUNT ? NULL : &CCONSTS[i - CTYPE_COUNT];
+        out    = rec;
+        *out++ = NULL == c ? 0xff : (unsigned char)c->kind;
+        *out++ = (unsigned char)(NULL == c ? CTYPES[i].size : c->size);
+        *out++ = (unsigned char)strlen(NULL == c ? CTYPES[i].name : c->name);
+        out    = putfield(out, NULL == c ? CTYPES[i].name : c->name, rec[2]);
+        if (NULL != c)
+        {
+          switch (c->kind)
+          {
+            case CONST_INT:     iv = constint(c); out = putfield(out, &iv, 8);    break;
+            case CONST_UINT:    out = putfield(out, &c->u, 8);                    break;
+            case CONST_DOUBLE:  out = putfield(out, &c->d, 8);                    break;
+            case CONST_LDOUBLE:
+              memset(out, 0, 16);
+              ld  = c->ld;
+              out = putfield(out, &ld, sizeof(ld) < 16 ? sizeof(ld) : 16);
+              out = rec + 3 + rec[2] + 16;
+              break;
+          }
+        }
+        fwrite(rec, 1, (size_t)(out - rec), stdout);
+      }
+      break;
+  }
+}
+
+enum { OP_ADD, OP_MUL, OP_DIV, OP_SHR, OP_CMP, OP_COUNT };
+enum { COST_LATENCY, COST_THROUGHPUT };
+
+static const char *OPNAME[OP_COUNT] = { "add", "mul", "div", "shr", "cmp" };
+
+#define EXPR_ADD(x, y) ((x) + (y))
+#define EXPR_MUL(x, y) ((x) * (y))
+#define EXPR_DIV(x, y) ((x) / (y))
+#define EXPR_SHR(x, y) ((x) >> (y))
+#define EXPR_CMP(x, y) ((x) + ((x) < (y)))
+
+#define REP8(s) s s s s s s s s
+
+// times n iterations of BENCH_UNROLL operations "x = EXPR(x, y)" and stores
+// the elapsed nanoseconds in ns. the latency kernel chains each operation on
+// the result of the previous one; the throughput kernel spreads them across
+// BENCH_UNROLL independent accumulators. the operand y is opaque, so that
+// multiplying or dividing by one still issues a real instruction.
+#define COST_KERNEL(T, HIDE, kind, n, x0, y0, EXPR, ns)                     \
+  do {                                                                      \
+    T y = (y0);                                                             \
+    HIDE(y);                                                                \
+    double start = nanotime();                                              \
+    if (COST_LATENCY == (kind))                                             \
+    {                                                                       \
+      T x = (x0);                                                           \
+      for (size_t i = 0; i < (n); ++i)                                      \
+      {                                                                     \
+        REP8(x = EXPR(x, y); HIDE(x);)                                      \
+      }                                                                     \
+    }                                                                       \
+    else                                                                    \
+    {                                                                       \
+      T a = (x0), b = (x0), c = (x0), d = (x0);                             \
+      T e = (x0), f = (x0), g = (x0), h = (x0);                             \
+      for (size_t i = 0; i < (n); ++i)                                      \
+      {                                                                     \
+        a = EXPR(a, y); b = EXPR(b, y); c = EXPR(c, y); d = EXPR(d, y);     \
+        e = EXPR(e, y); f = EXPR(f, y); g = EXPR(g, y); h = EXPR(h, y);     \
+        HIDE(a); HIDE(b); HIDE(c); HIDE(d);                                 \
+        HIDE(e); HIDE(f); HIDE(g); HIDE(h);                                 \
+      }                                                                     \
+    }                                                                       \
+    (ns) = nanotime() - start;                                              \
+  } while (0)
+
+// integer kernels divide a full-width dividend (bytes of 0x55) by one, so the
+// quotient has as many significant bits as the type allows. shifting right by
+// one and adding small values never overflows within BENCH_MAX_ITER.
+#define DEFINE_INTCOST(sfx, T)                                              \
+  double cost_##sfx(const int op, const int kind, const size_t n)           \
+  {                                                                         \
+    double ns = 0.0;                                                        \
+    T wide;                                                                 \
+    memset(&wide, 0x55, sizeof(wide));                                      \
+    switch (op)                                                             \
+    {                                                                       \
+      case OP_ADD: COST_KERNEL(T, OPAQUE, kind, n, 1, 1, EXPR_ADD, ns); break; \
+      case OP_MUL: COST_KERNEL(T, OPAQUE, kind, n, 1, 1, EXPR_MUL, ns); break; \
+      case OP_DIV: COST_KERNEL(T, OPAQUE, kind, n, wide, 1, EXPR_DIV, ns); break; \
+      case OP_SHR: COST_KERNEL(T, OPAQUE, kind, n, wide, 1, EXPR_SHR, ns); break; \
+      case OP_CMP: COST_KERNEL(T, OPAQUE, kind, n, 1, 0, EXPR_CMP, ns); break; \
+    }                                                                       \
+    return ns;                                                              \
+  }
+
+// floating-point kernels keep every operand normal, because subnormals take a
+// microcoded slow path on most hardware. there is no shift, so OP_SHR is
+// skipped when printing.
+#define DEFINE_FLTCOST(sfx, T, HIDE)                                        \
+  double cost_##sfx(const int op, const int kind, const size_t n)           \
+  {                                                                         \
+    double ns = 0.0;                                                        \
+    switch (op)                                                             \
+    {                                                                       \
+      case OP_ADD: COST_KERNEL(T, HIDE, kind, n, 1, 1, EXPR_ADD, ns); break; \
+      case OP_MUL: COST_KERNEL(T, HIDE, kind, n, 1.5, 1, EXPR_MUL, ns); break; \
+      case OP_DIV: COST_KERNEL(T, HIDE, kind, n, 1.5, 1, EXPR_DIV, ns); break; \
+      case OP_CMP: COST_KERNEL(T, HIDE, kind, n, 1, 0, EXPR_CMP, ns); break; \
+    }                                                                       \
+    return ns;                                                              \
+  }
+
+DEFINE_INTCOST(char,   char)
+DEFINE_INTCOST(schar,  signed char)
+DEFINE_INTCOST(uchar,  unsigned char)
+DEFINE_INTCOST(short,  short)
+DEFINE_INTCOST(ushort, unsigned short)
+DEFINE_INTCOST(int,    int)
+DEFINE_INTCOST(uint,   unsigned int)
+DEFINE_INTCOST(long,   long)
+DEFINE_INTCOST(ulong,  unsigned long)
+DEFINE_INTCOST(llong,  long long)
+DEFINE_INTCOST(ullong, unsigned long long)
+DEFINE_INTCOST(intmax, intmax_t)
+DEFINE_INTCOST(uintmax, uintmax_t)
+DEFINE_INTCOST(size,   size_t)
+DEFINE_INTCOST(ssize,  ssize_t)
+#if defined(__SIZEOF_INT128__)
+DEFINE_INTCOST(int128,  __int128)
+DEFINE_INTCOST(uint128, unsigned __int128)
+#endif
+#if defined(__FLT16_MAX__)
+DEFINE_FLTCOST(float16, _Float16, OPAQUE_FP)
+#endif
+DEFINE_FLTCOST(float,  float,       OPAQUE_FP)
+DEFINE_FLTCOST(double, double,      OPAQUE_FP)
+DEFINE_FLTCOST(ldouble, long double, OPAQUE_LD)
+#if defined(__SIZEOF_FLOAT128__)
+DEFINE_FLTCOST(float128, __float128, OPAQUE_FP)
+#endif
+
+typedef double (*costfn)(const int, const int, const size_t);
+
+static const struct
+{
+  const char *name;
+  size_t      size;
+  costfn      cost;
+  bool        isint;
+}
+COSTTYPES[] = {
+  { "char",               sizeof(char),               cost_char,    true  },
+  { "signed char",        sizeof(signed char),        cost_schar,   true  },
+  { "unsigned char",      sizeof(unsigned char),      cost_uchar,   true  },
+  { "short",              sizeof(short),              cost_short,   true  },
+  { "unsigned short",     sizeof(unsigned short),     cost_ushort,  true  },
+  { "int",                sizeof(int),                cost_int,     true  },
+  { "unsigned int",       sizeof(unsigned int),       cost_uint,    true  },
+  { "long",               sizeof(long),               cost_long,    true  },
+  { "unsigned long",      sizeof(unsigned long),      cost_ulong,   true  },
+  { "long long",          sizeof(long long),          cost_llong,   true  },
+  { "unsigned long long", sizeof(unsigned long long), cost_ullong,  true  },
+  { "intmax_t",           sizeof(intmax_t),           cost_intmax,  true  },
+  { "uintmax_t",          sizeof(uintmax_t),          cost_uintmax, true  },
+  { "size_t",             sizeof(size_t),             cost_size,    true  },
+  { "ssize_t",            sizeof(ssize_t),            cost_ssize,   true  },
+#if defined(__SIZEOF_INT128__)
+  { "__int128",           sizeof(__int128),           cost_int128,  true  },
+  { "unsigned __int128",  sizeof(unsigned __int128),  cost_uint128, true  },
+#endif
+#if defined(__FLT16_MAX__)
+  { "_Float16",           sizeof(_Float16),           cost_float16, false },
+#endif
+  { "float",              sizeof(float),              cost_float,   false },
+  { "double",             sizeof(double),             cost_double,  false },
+  { "long double",        sizeof(long double),        cost_ldouble, false },
+#if defined(__SIZEOF_FLOAT128__)
+  { "__float128",         sizeof(__float128),         cost_float128, false },
+#endif
+};
+
+struct costrun
+{
+  costfn cost;
+  int    op;
+  int    kind;
+  size_t n;
+};
+
+double runcost(void *arg)
+{
+  struct costrun *run = arg;
+
+  return run->cost(run->op, run->kind, run->n);
+}
+
+// returns the nanoseconds per operation of the given kernel. the iteration
+// count is doubled until a run lasts at least BENCH_MIN_NS, and then the
+// median of sample()'s runs is kept.
+double costof(const costfn cost, const int op, const int kind)
+{
+  struct costrun run = { cost, op, kind, 1024 };
+
+  while (runcost(&run) < BENCH_MIN_NS && run.n < BENCH_MAX_ITER)
+    run.n *= 2;
+
+  return sample(runcost, &run, NULL) / (run.n * BENCH_UNROLL);
+}
+
+// estimates the core clock in GHz from the latency of a dependent chain of
+// 64-bit integer additions, which retire at one per cycle on every CPU this
+// is likely to run on. unlike the TSC, this follows turbo and power states.
+double cpughz()
+{
+  return 1.0 / costof(cost_ullong, OP_ADD, COST_LATENCY);
+}
+
+// the cost table repeats each type's size beside its costs rather than
+// widening printsizes(): the size table is instant and never cached, while
+// this one is a measured section, replayed from the profile and selected on
+// its own with --only and --skip
+void printcosts()
+{
+  const char *majorline = ruler('=');
+  const char *minorline = ruler('-');
+
+  double ghz = cpughz();
+  double lat = 0.0;
+  double tpt = 0.0;
+  size_t t   = 0;
+  int    op  = 0;
+
+  publish(ghz, "cpu_ghz");
+
+  puts(majorline);
+  printf("%*s\n", LINE_WIDTH - 2, "PRIMITIVE DATA TYPE ARITHMETIC COSTS");
+  puts(majorline);
+
+  putchar('\n');
+  printf("\testimated core clock: %.2f GHz (assumes 1-cycle integer add latency)\n" \
+         "\tlatency: dependent chain of operations, ns/op and cycles/op\n" \
+         "\tthroughput: %d independent streams, ns/op and ops/cycle\n" \
+         "\tdiv: full-width dividend; cmp: compare feeding a dependent add\n",
+    ghz, BENCH_UNROLL);
+
+  putchar('\n');
+  puts(minorline);
+  raprintf(LINE_WIDTH, "%*s: %5s %4s | %10s %10s | %10s %10s\n",
+    CSYM_WIDTH, "type", "bytes", "op", "lat ns", "lat cyc", "tput ns", "ops/cyc");
+
+  for (t = 0; t < sizeof(COSTTYPES) / sizeof(*COSTTYPES); ++t)
+  {
+    puts(minorline);
+    for (op = 0; op < OP_COUNT; ++op)
+    {
+      if (OP_SHR == op && !COSTTYPES[t].isint)
+        continue;
+
+      lat = costof(COSTTYPES[t].cost, op, COST_LATENCY);
+      tpt = costof(COSTTYPES[t].cost, op, COST_THROUGHPUT);
+
+      if (0 == op)
+        raprintf(LINE_WIDTH, "%*s: %5zu %4s | %10.3f %10.2f | %10.3f %10.2f\n",
+          CSYM_WIDTH, COSTTYPES[t].name, COSTTYPES[t].size, OPNAME[op],
+          lat, lat * ghz, tpt, 1.0 / (tpt * ghz));
+      else
+        raprintf(LINE_WIDTH, "%*s  %5s %4s | %10.3f %10.2f | %10.3f %10.2f\n",
+          CSYM_WIDTH, "", "", OPNAME[op],
+          lat, lat * ghz, tpt, 1.0 / (tpt * ghz));
+    }
+  }
+  puts(minorline);
+
+  printquality();
+  putchar('\n');
+}
+
+#define MEMORY_MIN_BYTES (4UL << 10) // smallest pointer-chase working set
+#define MEMORY_MAX_BYTES (4UL << 30) // largest, if enough memory is free
+#define MEMORY_LOADS     (1UL << 21) // dependent loads timed per working set
+#define MEMORY_RISE      1.15        // latency ratio of a point still in transition
+#define MEMORY_JUMP      1.50        // total latency ratio that marks a new level
+#define MEMORY_LEVELS    4
+
+static uint64_t rngstate = 0x9e3779b97f4a7c15ULL;
+
+// splitmix64, good enough to defeat hardware prefetchers
+uint64_t nextrand()
+{
+  uint64_t z = (rngstate += 0x9e3779b97f4a7c15ULL);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+  return z ^ (z >> 31);
+}
+
+// reads the first line of a file into buf, stripping the trailing newline
+bool readline(const char *path, char *buf, const size_t size)
+{
+  FILE *file = fopen(path, "r");
+  bool  ok   = false;
+
+  if (NULL != file)
+  {
+    if ((ok = (NULL != fgets(buf, size, file))))
+      buf[strcspn(buf, "\n")] = '\0';
+    fclose(file);
+  }
+
+  return ok;
+}
+
+// parses sizes like "48K", "2048K", "32M" as used in sysfs
+size_t parsesize(const char *str)
+{
+  char  *end  = NULL;
+  size_t size = strtoull(str, &end, 10);
+
+  switch (*end)
+  {
+    case 'K': case 'k': return size << 10;
+    case 'M': case 'm': return size << 20;
+    case 'G': case 'g': return size << 30;
+    default:            return size;
+  }
+}
+
+// the L1 data cache line size, or 64 where the system does not say
+size_t cachelinesize()
+{
+  long line = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+
+  return line >= (long)sizeof(void *) ? (size_t)line : 64;
+}
+
+// the smallest huge page size the kernel offers, or 0 without huge pages
+size_t hugepagesize()
+{
+  DIR           *dir  = opendir("/sys/kernel/mm/hugepages");
+  struct dirent *ent  = NULL;
+  size_t         kb   = 0;
+  size_t         huge = 0;
+
+  if (NULL == dir)
+    return 0;
+  while (NULL != (ent = readdir(dir)))
+    if (1 == sscanf(ent->d_name, "hugepages-%zukB", &kb) && (0 == huge || kb << 10 < huge))
+      huge = kb << 10;
+  closedir(dir);
+
+  return huge;
+}
+
+// links every stride-sized line of buf into a single randomized cycle with
+// Sattolo's algorithm, computed in place so that working sets of several GiB
+// need no auxiliary index array, and returns the head of the chain.
+void **buildchase(char *buf, const size_t bytes, const size_t stride)
+{
+  size_t lines = bytes / stride;
+  size_t i     = 0;
+  size_t j     = 0;
+  size_t tmp   = 0;
+
+  for (i = 0; i < lines; ++i)
+    *(size_t *)(buf + i * stride) = i;
+
+  for (i = lines - 1; i > 0; --i)
+  {
+    j   = nextrand() % i;
+    tmp = *(size_t *)(buf + i * stride);
+    *(size_t *)(buf + i * stride) = *(size_t *)(buf + j * stride);
+    *(size_t *)(buf + j * stride) = tmp;
+  }
+
+  for (i = 0; i < lines; ++i)
+    *(void **)(buf + i * stride) = buf + *(size_t *)(buf + i * stride) * stride;
+
+  return (void **)buf;
+}
+
+// follows n links of the chain and returns the elapsed nanoseconds. every
+// load depends on the previous one, so this is the load-to-use latency.
+double chase(void **head, const size_t n)
+{
+  void **p     = head;
+  size_t i     = 0;
+  double start = nanotime();
+
+  for (i = 0; i < n; i += BENCH_UNROLL)
+  {
+    REP8(p = (void **)*p;)
+  }
+  OPAQUE(p);
+
+  return nanotime() - start;
+}
+
+double runchase(void *head)
+{
+  return chase(head, MEMORY_LOADS);
+}
+
+void printmemory()
+{
+  const char *majorline = ruler('=');
+  const char *minorline = ruler('-');
+
+  size_t stride  = cachelinesize();
+  size_t maxsize = (size_t)sysconf(_SC_AVPHYS_PAGES) * (size_t)sysconf(_SC_PAGESIZE) / 2;
+  double ghz     = cpughz();
+
+  size_t sizes[2 * 8 * sizeof(size_t)];
+  double nsper[2 * 8 * sizeof(size_t)];
+  size_t count   = 0;
+
+  size_t levelsize[MEMORY_LEVELS]; // index into sizes of each level's capacity
+  size_t levelnext[MEMORY_LEVELS]; // index into sizes where the next plateau starts
+  double levelrise[MEMORY_LEVELS]; // latency ratio across each level's boundary
+  size_t levels  = 0;
+  size_t known   = 0;
+  size_t start   = 0;
+  size_t k       = 0;
+  double jump    = 0.0;
+
+  char  *buf     = NULL;
+  void **head    = NULL;
+  size_t size    = 0;
+  size_t i       = 0;
+  int    r       = 0;
+  double ns      = 0.0;
+
+  char   path[256];
+  char   line[64];
+  char   type[64];
+  int    index   = 0;
+  int    level   = 0;
+
+  static const int SYSCONFSIZE[] = {
+    _SC_LEVEL1_DCACHE_SIZE, _SC_LEVEL2_CACHE_SIZE,
+    _SC_LEVEL3_CACHE_SIZE,  _SC_LEVEL4_CACHE_SIZE,
+  };
+
+  if (maxsize > MEMORY_MAX_BYTES)
+    maxsize = MEMORY_MAX_BYTES;
+
+  publish((double)stride, "cache_line");
+
+  puts(majorline);
+  printf("%*s\n", LINE_WIDTH - 2, "MEMORY HIERARCHY LATENCY");
+  puts(majorline);
+
+  putchar('\n');
+  printf("\tload-to-use latency of a randomized pointer chase, one %zu-byte line per link\n" \
+         "\tworking sets grow in steps of 1.5x and 1.33x up to %zu MiB (half of free memory)\n",
+    stride, maxsize >> 20);
+
+  buf = mmap(NULL, maxsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (MAP_FAILED == buf)
+  {
+    perror("mmap");
+    return;
+  }
+
+  putchar('\n');
+  puts(minorline);
+  raprintf(LINE_WIDTH, "%*s: %12s %12s\n", CSYM_WIDTH, "working set", "ns/load", "cycles/load");
+  puts(minorline);
+
+  // alternate between powers of two and 1.5x powers of two
+  for (size = MEMORY_MIN_BYTES; size <= maxsize; size = (size & (size - 1)) ? size / 3 * 4 : size / 2 * 3)
+  {
+    head = buildchase(buf, size, stride);
+    (void)chase(head, size / stride < MEMORY_LOADS ? size / stride : MEMORY_LOADS);
+
+    nsper[count]  = sample(runchase, head, NULL) / MEMORY_LOADS;
+    sizes[count]  = size;
+
+    raprintf(LINE_WIDTH, "%*zu KiB %12.2f %12.1f\n", CSYM_WIDTH - 4, size >> 10, nsper[count], nsper[count] * ghz);
+    (void)fflush(stdout);
+    ++count;
+  }
+  puts(minorline);
+
+  (void)munmap(buf, maxsize);
+
+  // consecutive working sets whose latency keeps rising form one transition,
+  // and the largest transitions (one per cache level the OS reports, or
+  // three if it reports none) are taken as the level boundaries. the gradual
+  // climb from TLB misses past the last level is thereby not mistaken for
+  // additional levels. each level's latency is the start of its plateau.
+  for (r = 0; r < (int)(sizeof(SYSCONFSIZE) / sizeof(*SYSCONFSIZE)); ++r)
+    if (sysconf(SYSCONFSIZE[r]) > 0)
+      ++known;
+  if (0 == known)
+    known = 3;
+
+  for (i = 1; i < count; ++i)
+  {
+    if (nsper[i] < nsper[i - 1] * MEMORY_RISE)
+      continue;
+
+    start = i;
+    while (i + 1 < count && nsper[i + 1] >= nsper[i] * MEMORY_RISE)
+      ++i;
+    jump = nsper[i] / nsper[start - 1];
+
+    if (jump < MEMORY_JUMP)
+      continue;
+
+    // keep the known largest transitions ordered by working-set size
+    if (levels == known)
+    {
+      for (r = 0, k = 1; k < levels; ++k)
+        if (levelrise[k] < levelrise[r])
+          r = (int)k;
+      if (levelrise[r] >= jump)
+        continue;
+      memmove(&levelsize[r], &levelsize[r + 1], (levels - r - 1) * sizeof(*levelsize));
+      memmove(&levelrise[r], &levelrise[r + 1], (levels - r - 1) * sizeof(*levelrise));
+      memmove(&levelnext[r], &levelnext[r + 1], (levels - r - 1) * sizeof(*levelnext));
+      --levels;
+    }
+    levelsize[levels] = start - 1;
+    levelrise[levels] = jump;
+    levelnext[levels] = i + 1 < count ? i + 1 : i;
+    ++levels;
+  }
+
+  putchar('\n');
+  puts(minorline);
+  raprintf(LINE_WIDTH, "%*s: %14s %10s %10s %14s\n", CSYM_WIDTH, "inferred level", "capacity", "ns", "cycles", "sysconf");
+  puts(minorline);
+  for (i = 0; i <= levels; ++i)
+  {
+    // a level is timed at the first size of its plateau
+    k  = i > 0 ? levelnext[i - 1] : 0;
+    ns = nsper[i < levels ? k : count - 1];
+    if (i < levels)
+    {
+      if (i < sizeof(SYSCONFSIZE) / sizeof(*SYSCONFSIZE) && sysconf(SYSCONFSIZE[i]) > 0)
+        (void)snprintf(line, sizeof(line), "%ld KiB", sysconf(SYSCONFSIZE[i]) >> 10);
+      else
+        strcpy(line, "-");
+      raprintf(LINE_WIDTH, "%*s%zu: %10zu KiB %10.2f %10.1f %14s\n", CSYM_WIDTH - 1, "L", i + 1,
+        sizes[levelsize[i]] >> 10, ns, ns * ghz, line);
+      publish((double)sizes[levelsize[i]], "L%zu_size", i + 1);
+      publish(ns, "L%zu_ns", i + 1);
+    }
+    else
+    {
+      raprintf(LINE_WIDTH, "%*s: %14s %10.2f %10.1f %14s\n", CSYM_WIDTH, "memory",
+        "-", ns, ns * ghz, "-");
+      publish(ns, "memory_ns");
+    }
+  }
+  puts(minorline);
+
+  putchar('\n');
+  puts(minorline);
+  raprintf(LINE_WIDTH, "%*s: %5s %11s %10s %6s %s\n", CSYM_WIDTH, "sysfs cpu0 cache", "level", "type", "size", "ways", "shared with cpus");
+  puts(minorline);
+  for (index = 0; ; ++index)
+  {
+    (void)snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+    if (!readline(path, line, sizeof(line)))
+      break;
+    level = atoi(line);
+
+    (void)snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+    if (!readline(path, type, sizeof(type)))
+      type[0] = '\0';
+
+    (void)snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+    size = readline(path, line, sizeof(line)) ? parsesize(line) : 0;
+
+    (void)snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/ways_of_associativity", index);
+    r = readline(path, line, sizeof(line)) ? atoi(line) : 0;
+
+    (void)snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/shared_cpu_list", index);
+    if (!readline(path, line, sizeof(line)))
+      strcpy(line, "?");
+
+    raprintf(LINE_WIDTH, "%*s%d: %5d %11s %6zu KiB %6d %s\n", CSYM_WIDTH - 1, "index", index,
+      level, type, size >> 10, r, line);
+  }
+  if (0 == index)
+    raprintf(LINE_WIDTH, "%*s: %s\n", CSYM_WIDTH, "sysfs cpu0 cache", "not available");
+  puts(minorline);
+
+  putchar('\n');
+  puts(minorline);
+  raprintf(LINE_WIDTH, "%*s: %12s %12s %12s %12s %12s\n", CSYM_WIDTH, "elements per level",
+    "lines", "int", "void *", "double", "long double");
+  puts(minorline);
+  for (i = 0; i < levels; ++i)
+  {
+    size = sizes[levelsize[i]];
+    raprintf(LINE_WIDTH, "%*s%zu: %12zu %12zu %12zu %12zu %12zu\n", CSYM_WIDTH - 1, "L", i + 1,
+      size / stride, size / sizeof(int), size / sizeof(void *),
+      size / sizeof(double), size / sizeof(long double));
+  }
+  puts(minorline);
+
+  printquality();
+  putchar('\n');
+}
+
+#define COPY_MIN_BYTES (16UL)        // smallest buffer in the bandwidth sweep
+#define COPY_MAX_BYTES (1UL << 30)   // largest, if enough memory is free
+#define COPY_MIN_NS    1.0e6         // minimum duration of a single timed run
+#define COPY_ALIGN     64            // misalignments 0..COPY_ALIGN-1 are swept
+
+// keeps the compiler from eliding or merging repeated copies into the same
+// destination buffer
+#define CLOBBER() __asm__ __volatile__("" ::: "memory")
+
+typedef void (*copyfn)(void *, const void *, size_t);
+
+// formats a byte count with the largest binary unit that divides it evenly
+char *sizestr(char *buf, const size_t len, const size_t n)
+{
+  if (n >= (1UL << 30) && 0 == (n & ((1UL << 30) - 1)))
+    (void)snprintf(buf, len, "%zu GiB", n >> 30);
+  else if (n >= (1UL << 20) && 0 == (n & ((1UL << 20) - 1)))
+    (void)snprintf(buf, len, "%zu MiB", n >> 20);
+  else if (n >= (1UL << 10) && 0 == (n & ((1UL << 10) - 1)))
+    (void)snprintf(buf, len, "%zu KiB", n >> 10);
+  else
+    (void)snprintf(buf, len, "%zu B", n);
+
+  return buf;
+}
+
+void copymemcpy(void *dst, const void *src, size_t n)
+{
+  memcpy(dst, src, n);
+}
+
+void copymemmove(void *dst, const void *src, size_t n)
+{
+  memmove(dst, src, n);
+}
+
+void copymemset(void *dst, const void *src, size_t n)
+{
+  (void)src;
+  memset(dst, 0x5a, n);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+// the string instruction microcoded for bulk copies ("enhanced rep movsb")
+void copymovsb(void *dst, const void *src, size_t n)
+{
+  __asm__ __volatile__("rep movsb" : "+D"(dst), "+S"(src), "+c"(n) : : "memory");
+}
+
+__attribute__((target("sse2")))
+void copysse2(void *dst, const void *src, size_t n)
+{
+  char       *d = dst;
+  const char *s = src;
+
+  for (; n >= 64; n -= 64, d += 64, s += 64)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i *)s + 0);
+    __m128i b = _mm_loadu_si128((const __m128i *)s + 1);
+    __m128i c = _mm_loadu_si128((const __m128i *)s + 2);
+    __m128i e = _mm_loadu_si128((const __m128i *)s + 3);
+    _mm_storeu_si128((__m128i *)d + 0, a);
+    _mm_storeu_si128((__m128i *)d + 1, b);
+    _mm_storeu_si128((__m128i *)d + 2, c);
+    _mm_storeu_si128((__m128i *)d + 3, e);
+  }
+  for (; n >= 16; n -= 16, d += 16, s += 16)
+    _mm_storeu_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+  while (n--)
+    *d++ = *s++;
+}
+
+__attribute__((target("avx2")))
+void copyavx2(void *dst, const void *src, size_t n)
+{
+  char       *d = dst;
+  const char *s = src;
+
+  for (; n >= 128; n -= 128, d += 128, s += 128)
+  {
+    __m256i a = _mm256_loadu_si256((const __m256i *)s + 0);
+    __m256i b = _mm256_loadu_si256((const __m256i *)s + 1);
+    __m256i c = _mm256_loadu_si256((const __m256i *)s + 2);
+    __m256i e = _mm256_loadu_si256((const __m256i *)s + 3);
+    _mm256_storeu_si256((__m256i *)d + 0, a);
+    _mm256_storeu_si256((__m256i *)d + 1, b);
+    _mm256_storeu_si256((__m256i *)d + 2, c);
+    _mm256_storeu_si256((__m256i *)d + 3, e);
+  }
+  for (; n >= 32; n -= 32, d += 32, s += 32)
+    _mm256_storeu_si256((__m256i *)d, _mm256_loadu_si256((const __m256i *)s));
+  while (n--)
+    *d++ = *s++;
+}
+
+// streams whole lines around the cache; the destination is aligned up to 16
+// bytes first because non-temporal stores require it
+__attribute__((target("sse2")))
+void copystream(void *dst, const void *src, size_t n)
+{
+  char       *d = dst;
+  const char *s = src;
+
+  for (; n > 0 && ((uintptr_t)d & 15); --n)
+    *d++ = *s++;
+  for (; n >= 64; n -= 64, d += 64, s += 64)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i *)s + 0);
+    __m128i b = _mm_loadu_si128((const __m128i *)s + 1);
+    __m128i c = _mm_loadu_si128((const __m128i *)s + 2);
+    __m128i e = _mm_loadu_si128((const __m128i *)s + 3);
+    _mm_stream_si128((__m128i *)d + 0, a);
+    _mm_stream_si128((__m128i *)d + 1, b);
+    _mm_stream_si128((__m128i *)d + 2, c);
+    _mm_stream_si128((__m128i *)d + 3, e);
+  }
+  _mm_sfence();
+  while (n--)
+    *d++ = *s++;
+}
+
+#endif
+
+static struct
+{
+  const char *name;
+  copyfn      copy;
+}
+COPYKERNELS[] = {
+  { "memcpy",  copymemcpy  },
+  { "memmove", copymemmove },
+  { "memset",  copymemset  },
+#if defined(__x86_64__) || defined(__i386__)
+  { "movsb",   copymovsb   },
+  { "sse2",    copysse2    }, // replaced with avx2 at runtime if supported
+  { "stream",  copystream  },
+#endif
+};
+
+#define COPY_KERNELS (sizeof(COPYKERNELS) / sizeof(*COPYKERNELS))
+
+struct copyrun
+{
+  copyfn      copy;
+  char       *dst;
+  const char *src;
+  size_t      n;
+  size_t      reps;
+};
+
+double runcopy(void *arg)
+{
+  struct copyrun *run   = arg;
+  double          start = nanotime();
+  size_t          i     = 0;
+
+  for (i = 0; i < run->reps; ++i)
+  {
+    run->copy(run->dst, run->src, run->n);
+    CLOBBER();
+  }
+
+  return nanotime() - start;
+}
+
+// returns the bandwidth in GB/s (bytes copied or set, not bytes moved across
+// the bus) of the given kernel, using the same calibration as costof()
+double copyrate(const copyfn copy, char *dst, const char *src, const size_t n)
+{
+  struct copyrun run = { copy, dst, src, n, 1 };
+
+  while (runcopy(&run) < COPY_MIN_NS)
+    run.reps *= 2;
+
+  return (double)(n * run.reps) / sample(runcopy, &run, NULL);
+}
+
+void printcopy()
+{
+  const char *majorline = ruler('=');
+  const char *minorline = ruler('-');
+
+  static const size_t MISALIGNSIZES[] = { 64, 4UL << 10, 256UL << 10, 8UL << 20 };
+
+  size_t maxsize = (size_t)sysconf(_SC_AVPHYS_PAGES) * (size_t)sysconf(_SC_PAGESIZE) / 4;
+  size_t mapsize = 0;
+  char  *src     = NULL;
+  char  *dst     = NULL;
+  size_t size    = 0;
+  size_t k       = 0;
+  size_t best    = 0;
+  size_t from[COPY_KERNELS];
+  size_t last[COPY_KERNELS];
+  double gbps[COPY_KERNELS];
+  double peak[COPY_KERNELS];
+  double aligned = 0.0;
+  double rate    = 0.0;
+  double worst[2];
+  int    worstoff[2];
+  int    off     = 0;
+  int    side    = 0;
+  size_t m       = 0;
+  char   cell[32];
+
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+  {
+    for (k = 0; k < COPY_KERNELS; ++k)
+    {
+      if (copysse2 == COPYKERNELS[k].copy)
+      {
+        COPYKERNELS[k].name = "avx2";
+        COPYKERNELS[k].copy = copyavx2;
+      }
+    }
+  }
+#endif
+
+  if (maxsize > COPY_MAX_BYTES)
+    maxsize = COPY_MAX_BYTES;
+  mapsize = maxsize + 2 * COPY_ALIGN;
+
+  puts(majorline);
+  printf("%*s\n", LINE_WIDTH - 2, "MEMORY COPY BANDWIDTH");
+  puts(majorline);
+
+  putchar('\n');
+  printf("\tGB/s of bytes copied (or set), median of runs of at least %.0f ms each\n" \
+         "\tbuffers are page-aligned and pre-faulted; sizes up to %s (a quarter of free memory)\n",
+    COPY_MIN_NS / 1.0e6, sizestr(cell, sizeof(cell), maxsize));
+
+  src = mmap(NULL, mapsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  dst = mmap(NULL, mapsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (MAP_FAILED == src || MAP_FAILED == dst)
+  {
+    perror("mmap");
+    return;
+  }
+  memset(src, 0xa5, mapsize);
+  memset(dst, 0x00, mapsize);
+
+  for (k = 0; k < COPY_KERNELS; ++k)
+  {
+    from[k] = last[k] = 0;
+    peak[k] = 0.0;
+  }
+
+  putchar('\n');
+  puts(minorline);
+  printf("%*s:", CSYM_WIDTH, "aligned size");
+  for (k = 0; k < COPY_KERNELS; ++k)
+    printf(" %8s", COPYKERNELS[k].name);
+  printf(" %8s\n", "fastest");
+  puts(minorline);
+
+  for (size = COPY_MIN_BYTES; size <= maxsize; size *= 2)
+  {
+    printf("%*s:", CSYM_WIDTH, sizestr(cell, sizeof(cell), size));
+
+    for (best = 0, k = 0; k < COPY_KERNELS; ++k)
+    {
+      gbps[k] = copyrate(COPYKERNELS[k].copy, dst, src, size);
+      printf(" %8.2f", gbps[k]);
+      if (gbps[k] > peak[k])
+        publish(peak[k] = gbps[k], "%s_gbps", COPYKERNELS[k].name);
+      (void)fflush(stdout);
+      if (copymemset != COPYKERNELS[k].copy && gbps[k] > gbps[best])
+        best = k;
+    }
+    printf(" %8s\n", COPYKERNELS[best].name);
+
+    if (0 == last[best])
+      from[best] = size;
+    last[best] = size;
+  }
+  puts(minorline);
+
+  putchar('\n');
+  puts(minorline);
+  printf("%*s: %10s .. %-10s (ranges may interleave)\n", CSYM_WIDTH, "fastest copy", "from", "to");
+  puts(minorline);
+  for (k = 0; k < COPY_KERNELS; ++k)
+  {
+    if (0 == last[k])
+      continue;
+    printf("%*s: %10s", CSYM_WIDTH, COPYKERNELS[k].name, sizestr(cell, sizeof(cell), from[k]));
+    printf(" .. %-10s\n", sizestr(cell, sizeof(cell), last[k]));
+  }
+  puts(minorline);
+
+  // every kernel at a few representative sizes, with the source offset from
+  // a line boundary by 0..COPY_ALIGN-1 bytes and the destination aligned,
+  // then vice versa; the worst case and its offset are reported
+  putchar('\n');
+  puts(minorline);
+  printf("%*s: %10s %10s %18s %18s\n", CSYM_WIDTH, "misalignment",
+    "size", "aligned", "worst src offset", "worst dst offset");
+  puts(minorline);
+  for (k = 0; k < COPY_KERNELS; ++k)
+  {
+    for (m = 0; m < sizeof(MISALIGNSIZES) / sizeof(*MISALIGNSIZES); ++m)
+    {
+      size = MISALIGNSIZES[m];
+      if (size > maxsize)
+        continue;
+
+      aligned = copyrate(COPYKERNELS[k].copy, dst, src, size);
+      for (side = 0; side < 2; ++side)
+      {
+        worst[side]    = aligned;
+        worstoff[side] = 0;
+        for (off = 1; off < COPY_ALIGN; ++off)
+        {
+          rate = 0 == side
+            ? copyrate(COPYKERNELS[k].copy, dst, src + off, size)
+            : copyrate(COPYKERNELS[k].copy, dst + off, src, size);
+          if (rate < worst[side])
+          {
+            worst[side]    = rate;
+            worstoff[side] = off;
+          }
+        }
+      }
+
+      printf("%*s%c %10s %10.2f %9.2f (+%2d B) %9.2f (+%2d B)\n",
+        CSYM_WIDTH, 0 == m ? COPYKERNELS[k].name : "", 0 == m ? ':' : ' ',
+        sizestr(cell, sizeof(cell), size), aligned,
+        worst[0], worstoff[0], worst[1], worstoff[1]);
+      (void)fflush(stdout);
+    }
+  }
+  puts(minorline);
+
+  (void)munmap(src, mapsize);
+  (void)munmap(dst, mapsize);
+
+  printquality();
+  putchar('\n');
+}
+
+#define LAYOUT_MAX_FIELDS 64   // fields accepted in a --layout list
+#define LAYOUT_EXHAUST    8    // lists up to this long are reordered exhaustively
+#define LAYOUT_COUNT      1024 // default array length for --layout
+
+// the alignment a member of type T actually receives inside a struct, which
+// can be weaker than _Alignof(T) (e.g., double and long long on i386)
+#define STRUCTALIGN(T) offsetof(struct { char c; T x; }, x)
+
+#define LAYOUTTYPE(T) { #T, sizeof(T), STRUCTALIGN(T), _Alignof(T) }
+
+static const struct
+{
+  const char *name;
+  size_t      size;
+  size_t      align;
+  size_t      alignof;
+}
+LAYOUTTYPES[] = {
+  LAYOUTTYPE(_Bool),
+  LAYOUTTYPE(bool),
+  LAYOUTTYPE(char),
+  LAYOUTTYPE(signed char),
+  LAYOUTTYPE(unsigned char),
+  LAYOUTTYPE(short),
+  LAYOUTTYPE(short int),
+  LAYOUTTYPE(signed short),
+  LAYOUTTYPE(signed short int),
+  LAYOUTTYPE(unsigned short),
+  LAYOUTTYPE(unsigned short int),
+  LAYOUTTYPE(int),
+  LAYOUTTYPE(signed),
+  LAYOUTTYPE(signed int),
+  LAYOUTTYPE(unsigned),
+  LAYOUTTYPE(unsigned int),
+  LAYOUTTYPE(long),
+  LAYOUTTYPE(long int),
+  LAYOUTTYPE(signed long),
+  LAYOUTTYPE(signed long int),
+  LAYOUTTYPE(unsigned long),
+  LAYOUTTYPE(unsigned long int),
+  LAYOUTTYPE(long long),
+  LAYOUTTYPE(long long int),
+  LAYOUTTYPE(signed long long),
+  LAYOUTTYPE(signed long long int),
+  LAYOUTTYPE(unsigned long long),
+  LAYOUTTYPE(unsigned long long int),
+  LAYOUTTYPE(float),
+  LAYOUTTYPE(double),
+  LAYOUTTYPE(long double),
+  LAYOUTTYPE(intmax_t),
+  LAYOUTTYPE(uintmax_t),
+  LAYOUTTYPE(size_t),
+  LAYOUTTYPE(ssize_t),
+  LAYOUTTYPE(intptr_t),
+  LAYOUTTYPE(uintptr_t),
+  LAYOUTTYPE(ptrdiff_t),
+  LAYOUTTYPE(int8_t),
+  LAYOUTTYPE(int16_t),
+  LAYOUTTYPE(int32_t),
+  LAYOUTTYPE(int64_t),
+  LAYOUTTYPE(uint8_t),
+  LAYOUTTYPE(uint16_t),
+  LAYOUTTYPE(uint32_t),
+  LAYOUTTYPE(uint64_t),
+  LAYOUTTYPE(void *),
+#if defined(__SIZEOF_INT128__)
+  LAYOUTTYPE(__int128),
+  LAYOUTTYPE(unsigned __int128),
+#endif
+#if defined(__FLT16_MAX__)
+  LAYOUTTYPE(_Float16),
+#endif
+#if defined(__SIZEOF_FLOAT128__)
+  LAYOUTTYPE(__float128),
+#endif
+};
+
+struct field
+{
+  size_t type;   // index into LAYOUTTYPES
+  size_t count;  // array length, 1 for scalars
+  size_t size;
+  size_t align;
+  size_t offset;
+};
+
+// compiler-generated structs the layout algorithm is checked against
+struct layoutcheck1 { char a; double b; int c; bool d; uint64_t e[3]; };
+struct layoutcheck2 { short a; char b[3]; long double c; char d; };
+struct layoutcheck3 { bool a; void *b; bool c; int16_t d; float e[5]; unsigned char f; };
+
+#define LAYOUTCHECK(spec, S, ...) { spec, sizeof(struct S), { __VA_ARGS__ } }
+
+static const struct
+{
+  const char *spec;
+  size_t      size;
+  size_t      offset[8];
+}
+LAYOUTCHECKS[] = {
+  LAYOUTCHECK("char,double,int,bool,uint64_t[3]", layoutcheck1,
+    offsetof(struct layoutcheck1, a), offsetof(struct layoutcheck1, b),
+    offsetof(struct layoutcheck1, c), offsetof(struct layoutcheck1, d),
+    offsetof(struct layoutcheck1, e)),
+  LAYOUTCHECK("short,char[3],long double,char", layoutcheck2,
+    offsetof(struct layoutcheck2, a), offsetof(struct layoutcheck2, b),
+    offsetof(struct layoutcheck2, c), offsetof(struct layoutcheck2, d)),
+  LAYOUTCHECK("bool,void *,bool,int16_t,float[5],unsigned char", layoutcheck3,
+    offsetof(struct layoutcheck3, a), offsetof(struct layoutcheck3, b),
+    offsetof(struct layoutcheck3, c), offsetof(struct layoutcheck3, d),
+    offsetof(struct layoutcheck3, e), offsetof(struct layoutcheck3, f)),
+};
+
+// parses a comma-separated list of type names, each optionally followed by
+// an array length in brackets. whitespace is normalized so that "unsigned
+// long", "unsigned  long" and " unsigned long " are the same type, and any
+// pointer type is treated as void *. returns the number of fields, or zero
+// with a message on stderr if the list cannot be parsed.
+size_t parselayout(const char *spec, struct field *field, const size_t max)
+{
+  char   name[64];
+  size_t len   = 0;
+  size_t n     = 0;
+  size_t t     = 0;
+  char  *end   = NULL;
+
+  while (*spec)
+  {
+    if (n == max)
+    {
+      fprintf(stderr, "error: more than %zu fields\n", max);
+      return 0;
+    }
+
+    for (len = 0; *spec && ',' != *spec && '[' != *spec; ++spec)
+    {
+      if (' ' == *spec || '\t' == *spec)
+      {
+        if (len > 0 && ' ' != name[len - 1])
+          name[len++] = ' ';
+      }
+      else if (len + 2 < sizeof(name))
+      {
+        if ('*' == *spec && len > 0 && ' ' != name[len - 1])
+          name[len++] = ' ';
+        name[len++] = *spec;
+      }
+    }
+    while (len > 0 && ' ' == name[len - 1])
+      --len;
+    name[len] = '\0';
+
+    if (len > 0 && '*' == name[len - 1])
+      strcpy(name, "void *");
+
+    for (t = 0; t < sizeof(LAYOUTTYPES) / sizeof(*LAYOUTTYPES); ++t)
+      if (0 == strcmp(name, LAYOUTTYPES[t].name))
+        break;
+    if (t == sizeof(LAYOUTTYPES) / sizeof(*LAYOUTTYPES))
+    {
+      fprintf(stderr, "error: unknown type: \"%s\"\n", name);
+      return 0;
+    }
+
+    field[n].type  = t;
+    field[n].count = 1;
+    if ('[' == *spec)
+    {
+      field[n].count = strtoull(spec + 1, &end, 10);
+      if (end == spec + 1 || ']' != *end || 0 == field[n].count)
+      {
+        fprintf(stderr, "error: invalid array length for \"%s\"\n", name);
+        return 0;
+      }
+      for (spec = end + 1; ' ' == *spec || '\t' == *spec; ++spec)
+        ;
+    }
+    field[n].size  = LAYOUTTYPES[t].size * field[n].count;
+    field[n].align = LAYOUTTYPES[t].align;
+    ++n;
+
+    if (',' == *spec)
+      ++spec;
+    else if (*spec)
+    {
+      fprintf(stderr, "error: expected ',' after \"%s\"\n", name);
+      return 0;
+    }
+  }
+
+  if (0 == n)
+    fprintf(stderr, "error: empty field list\n");
+
+  return n;
+}
+
+// assigns offsets to the fields in the given order the way a C compiler does
+// (each member at the next multiple of its alignment, the whole rounded up to
+// the strictest alignment) and returns the size of the struct
+size_t layout(struct field *field, const size_t *order, const size_t n, size_t *align)
+{
+  size_t offset = 0;
+  size_t i      = 0;
+
+  for (*align = 1, i = 0; i < n; ++i)
+  {
+    struct field *f = &field[order[i]];
+    offset    = (offset + f->align - 1) / f->align * f->align;
+    f->offset = offset;
+    offset   += f->size;
+    if (f->align > *align)
+      *align = f->align;
+  }
+
+  return (offset + *align - 1) / *align * *align;
+}
+
+// counts the fields that straddle a cache-line boundary over an array of
+// count structs starting on a line boundary. the pattern repeats every
+// line / gcd(size, line) elements, so only one period is walked.
+size_t straddles(const struct field *field, const size_t n, const size_t size,
+  const size_t line, const size_t count)
+{
+  size_t period = line;
+  size_t g      = size;
+  size_t r      = line;
+  size_t tmp    = 0;
+  size_t once   = 0;
+  size_t rest   = 0;
+  size_t i      = 0;
+  size_t e      = 0;
+  size_t start  = 0;
+
+  while (0 != r)
+  {
+    tmp = g % r;
+    g   = r;
+    r   = tmp;
+  }
+  period = line / g;
+
+  for (e = 0; e < period && e < count; ++e)
+  {
+    for (i = 0; i < n; ++i)
+    {
+      start = e * size + field[i].offset;
+      if (start / line != (start + field[i].size - 1) / line)
+      {
+        if (e < count % period)
+          ++rest;
+        ++once;
+      }
+    }
+  }
+
+  return count < period ? once : (count / period) * once + rest;
+}
+
+// prints the fields in the given order, pahole-style, with padding holes
+void printfields(const struct field *field, const size_t *order, const size_t n,
+  const size_t size, const size_t line)
+{
+  size_t end = 0;
+  size_t i   = 0;
+  char   decl[96];
+
+  for (i = 0; i < n; ++i)
+  {
+    const struct field *f = &field[order[i]];
+    if (f->offset > end)
+      printf("%*s  %6s %6zu %6s  /* %zu-byte hole */\n", CSYM_WIDTH, "", "", f->offset - end, "", f->offset - end);
+
+    if (f->count > 1)
+      (void)snprintf(decl, sizeof(decl), "%s[%zu]", LAYOUTTYPES[f->type].name, f->count);
+    else
+      (void)snprintf(decl, sizeof(decl), "%s", LAYOUTTYPES[f->type].name);
+
+    printf("%*s: %6zu %6zu %6zu%s\n", CSYM_WIDTH, decl, f->offset, f->size, f->align,
+      f->offset / line != (f->offset + f->size - 1) / line ? "  /* straddles a cache line */" : "");
+    end = f->offset + f->size;
+  }
+  if (size > end)
+    printf("%*s  %6s %6zu %6s  /* %zu-byte tail padding */\n", CSYM_WIDTH, "", "", size - end, "", size - end);
+}
+
+// prints the size, padding and cache-line footprint of one layout
+void printfootprint(const struct field *field, const size_t n, const size_t size,
+  const size_t align, const size_t line, const size_t count)
+{
+  size_t used = 0;
+  size_t i    = 0;
+
+  for (i = 0; i < n; ++i)
+    used += field[i].size;
+
+  printf("\tsize %zu, alignment %zu, %zu bytes of padding (%.1f%%)\n",
+    size, align, size - used, 100.0 * (size - used) / size);
+  printf("\tone element spans %zu cache line(s) when line-aligned; %zu elements span %zu lines\n",
+    (size + line - 1) / line, count, (size * count + line - 1) / line);
+  printf("\t%zu of %zu fields straddle a cache line across the %zu-element array\n",
+    straddles(field, n, size, line, count), n * count, count);
+}
+
+// searches every permutation of the first k fields for the order that gives
+// the smallest struct, breaking ties by the fewest straddling fields
+void bestorder(struct field *field, const size_t n, size_t *order, const size_t k,
+  size_t *best, size_t *bestsize, size_t *beststraddle, const size_t line, const size_t count)
+{
+  size_t align = 0;
+  size_t size  = 0;
+  size_t cross = 0;
+  size_t i     = 0;
+  size_t tmp   = 0;
+
+  if (k <= 1)
+  {
+    size  = layout(field, order, n, &align);
+    cross = straddles(field, n, size, line, count);
+    if (size < *bestsize || (size == *bestsize && cross < *beststraddle))
+    {
+      *bestsize     = size;
+      *beststraddle = cross;
+      memcpy(best, order, n * sizeof(*order));
+    }
+    return;
+  }
+
+  for (i = 0; i < k; ++i)
+  {
+    bestorder(field, n, order, k - 1, best, bestsize, beststraddle, line, count);
+    tmp = order[k - 1];
+    order[k - 1] = order[0 == k % 2 ? i : 0];
+    order[0 == k % 2 ? i : 0] = tmp;
+  }
+}
+
+// verifies the layout algorithm against the compiler's own structs, and the
+// struct-member alignment of every type against _Alignof
+bool checklayout(size_t *checked)
+{
+  struct field field[LAYOUT_MAX_FIELDS];
+  size_t order[LAYOUT_MAX_FIELDS];
+  size_t align = 0;
+  size_t n     = 0;
+  size_t c     = 0;
+  size_t i     = 0;
+  bool   match = true;
+  bool   ok    = true;
+
+  for (c = 0; c < sizeof(LAYOUTCHECKS) / sizeof(*LAYOUTCHECKS); ++c)
+  {
+    n = parselayout(LAYOUTCHECKS[c].spec, field, LAYOUT_MAX_FIELDS);
+    for (i = 0; i < n; ++i)
+      order[i] = i;
+    match = LAYOUTCHECKS[c].size == layout(field, order, n, &align);
+    for (i = 0; i < n; ++i)
+      if (LAYOUTCHECKS[c].offset[i] != field[i].offset)
+        match = false;
+    if (!match)
+      fprintf(stderr, "error: computed layout of {%s} differs from the compiler's\n", LAYOUTCHECKS[c].spec);
+    ok = ok && match;
+  }
+
+  for (i = 0; i < sizeof(LAYOUTTYPES) / sizeof(*LAYOUTTYPES); ++i)
+    if (LAYOUTTYPES[i].align != LAYOUTTYPES[i].alignof)
+      printf("\tnote: %s is %zu-byte aligned as a member but _Alignof is %zu\n",
+        LAYOUTTYPES[i].name, LAYOUTTYPES[i].align, LAYOUTTYPES[i].alignof);
+
+  *checked = c;
+
+  return ok;
+}
+
+bool printlayout(const char *spec, const size_t count)
+{
+  const char *majorline = ruler('=');
+  const char *minorline = ruler('-');
+
+  struct field field[LAYOUT_MAX_FIELDS];
+  size_t order[LAYOUT_MAX_FIELDS];
+  size_t best[LAYOUT_MAX_FIELDS];
+  size_t line      = (size_t)sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+  size_t n         = parselayout(spec, field, LAYOUT_MAX_FIELDS);
+  size_t size      = 0;
+  size_t align     = 0;
+  size_t bestsize  = SIZE_MAX;
+  size_t bestcross = SIZE_MAX;
+  size_t checked   = 0;
+  size_t i         = 0;
+  size_t j         = 0;
+  size_t tmp       = 0;
+
+  if (0 == n)
+    return false;
+  if (line < 2)
+    line = 64;
+
+  puts(majorline);
+  printf("%*s\n", LINE_WIDTH - 2, "STRUCT LAYOUT");
+  puts(majorline);
+
+  putchar('\n');
+  printf("\t{ %s }, %zu-byte cache lines, arrays of %zu elements\n", spec, line, count);
+  if (!checklayout(&checked))
+    return false;
+  printf("\tlayout rules verified against %zu compiler-generated structs\n", checked);
+
+  for (i = 0; i < n; ++i)
+    order[i] = i;
+  size = layout(field, order, n, &align);
+
+  putchar('\n');
+  puts(minorline);
+  printf("%*s: %6s %6s %6s\n", CSYM_WIDTH, "as declared", "offset", "size", "align");
+  puts(minorline);
+  printfields(field, order, n, size, line);
+  puts(minorline);
+  printfootprint(field, n, size, align, line, count);
+
+  // exhaustive search for short lists; otherwise decreasing alignment, which
+  // is optimal for size whenever sizes are multiples of their alignment
+  if (n <= LAYOUT_EXHAUST)
+  {
+    bestorder(field, n, order, n, best, &bestsize, &bestcross, line, count);
+  }
+  else
+  {
+    for (i = 0; i < n; ++i)
+      best[i] = i;
+    for (i = 1; i < n; ++i)
+    {
+      for (j = i; j > 0 && field[best[j]].align > field[best[j - 1]].align; --j)
+      {
+        tmp         = best[j];
+        best[j]     = best[j - 1];
+        best[j - 1] = tmp;
+      }
+    }
+  }
+  size = layout(field, best, n, &align);
+
+  putchar('\n');
+  puts(minorline);
+  printf("%*s: %6s %6s %6s\n", CSYM_WIDTH, "suggested", "offset", "size", "align");
+  puts(minorline);
+  printfields(field, best, n, size, line);
+  puts(minorline);
+  printfootprint(field, n, size, align, line, count);
+
+  putchar('\n');
+
+  return true;
+}
+
+#define ATOMIC_OPS          (1UL << 20) // operations per thread per timed run
+#define ATOMIC_MAX_THREADS  16          // threads contending for one line
+#define PINGPONG_ROUNDS     20000       // round trips per pair of CPUs
+#define PINGPONG_MAX_CPUS   16          // largest core-to-core matrix printed
+#define SHARING_STRIDE      128         // counter spacing that defeats adjacent-line prefetch
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPURELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define CPURELAX() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define CPURELAX() CLOBBER()
+#endif
+
+typedef double (*atomicfn)(void *, const size_t);
+
+// defines fetch-and-add and compare-and-swap increment kernels for one
+// width, each returning the elapsed nanoseconds for n operations
+#define DEFINE_ATOMIC(sfx, T)                                               \
+  double atomicadd_##sfx(void *target, const size_t n)                      \
+  {                                                                         \
+    T     *x     = target;                                                  \
+    size_t i     = 0;                                                       \
+    double start = nanotime();                                              \
+    for (i = 0; i < n; ++i)                                                 \
+      (void)__atomic_fetch_add(x, 1, __ATOMIC_SEQ_CST);                     \
+    return nanotime() - start;                                              \
+  }                                                                         \
+  double atomiccas_##sfx(void *target, const size_t n)                      \
+  {                                                                         \
+    T     *x     = target;                                                  \
+    T      old   = __atomic_load_n(x, __ATOMIC_RELAXED);                    \
+    size_t i     = 0;                                                       \
+    double start = nanotime();                                              \
+    for (i = 0; i < n; ++i)                                                 \
+      while (!__atomic_compare_exchange_n(x, &old, (T)(old + 1), false,     \
+                __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))                        \
+        ;                                                                   \
+    return nanotime() - start;                                              \
+  }
+
+DEFINE_ATOMIC(8,  uint8_t)
+DEFINE_ATOMIC(16, uint16_t)
+DEFINE_ATOMIC(32, uint32_t)
+DEFINE_ATOMIC(64, uint64_t)
+
+#if defined(__x86_64__)
+
+#include <cpuid.h>
+
+bool hascx16()
+{
+  unsigned a = 0, b = 0, c = 0, d = 0;
+
+  return __get_cpuid(1, &a, &b, &c, &d) && (c & bit_CMPXCHG16B);
+}
+
+// the 16-byte kernels are compiled for cmpxchg16b explicitly, since the
+// default x86-64 target does not assume it and would call into libatomic
+__attribute__((target("cx16")))
+double atomiccas_128(void *target, const size_t n)
+{
+  unsigned __int128 *x     = target;
+  unsigned __int128  old   = *x;
+  unsigned __int128  seen  = 0;
+  size_t             i     = 0;
+  double             start = nanotime();
+
+  for (i = 0; i < n; ++i)
+    while (old != (seen = __sync_val_compare_and_swap(x, old, old + 1)))
+      old = seen;
+
+  return nanotime() - start;
+}
+
+#else
+
+bool hascx16()
+{
+  return false;
+}
+
+#endif
+
+static const struct
+{
+  const char *name;
+  int         bits;
+  atomicfn    add;
+  atomicfn    cas;
+}
+ATOMICWIDTHS[] = {
+  { "8-bit",     8, atomicadd_8,  atomiccas_8  },
+  { "16-bit",   16, atomicadd_16, atomiccas_16 },
+  { "32-bit",   32, atomicadd_32, atomiccas_32 },
+  { "64-bit",   64, atomicadd_64, atomiccas_64 },
+#if defined(__x86_64__)
+  { "128-bit", 128, NULL,         atomiccas_128 }, // only if hascx16()
+#endif
+};
+
+// plain increments of a private counter, to expose false sharing
+double counterinc(void *target, const size_t n)
+{
+  volatile uint64_t *x     = target;
+  size_t             i     = 0;
+  double             start = nanotime();
+
+  for (i = 0; i < n; ++i)
+    ++*x;
+
+  return nanotime() - start;
+}
+
+struct atomicjob
+{
+  int      cpu;
+  atomicfn fn;
+  void    *target;
+  int     *ready;   // start barrier shared by all jobs of a run
+  int      threads;
+  double   ns;
+};
+
+// pins the calling thread to a single CPU
+bool pin(const int cpu)
+{
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  return 0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// lists the CPUs this process may run on
+int cpulist(int *cpus, const int max)
+{
+  cpu_set_t set;
+  int       n   = 0;
+  int       cpu = 0;
+
+  if (0 != sched_getaffinity(0, sizeof(set), &set))
+    return 0;
+
+  for (cpu = 0; cpu < CPU_SETSIZE && n < max; ++cpu)
+    if (CPU_ISSET(cpu, &set))
+      cpus[n++] = cpu;
+
+  return n;
+}
+
+void *atomicthread(void *arg)
+{
+  struct atomicjob *job = arg;
+
+  (void)pin(job->cpu);
+
+  (void)__atomic_add_fetch(job->ready, 1, __ATOMIC_SEQ_CST);
+  while (__atomic_load_n(job->ready, __ATOMIC_ACQUIRE) < job->threads)
+    CPURELAX();
+
+  job->ns = job->fn(job->target, ATOMIC_OPS);
+
+  return NULL;
+}
+
+// runs fn on one thread per given CPU at once, thread t operating on
+// base + t * stride, and returns the mean nanoseconds per operation
+double runatomic(const atomicfn fn, char *base, const size_t stride, const int *cpus, const int threads)
+{
+  pthread_t        tid[ATOMIC_MAX_THREADS];
+  struct atomicjob job[ATOMIC_MAX_THREADS];
+  int              ready = 0;
+  double           total = 0.0;
+  int              t     = 0;
+
+  for (t = 0; t < threads; ++t)
+  {
+    job[t].cpu     = cpus[t];
+    job[t].fn      = fn;
+    job[t].target  = base + t * stride;
+    job[t].ready   = &ready;
+    job[t].threads = threads;
+    job[t].ns      = 0.0;
+    if (0 != pthread_create(&tid[t], NULL, atomicthread, &job[t]))
+    {
+      perror("pthread_create");
+      exit(1);
+    }
+  }
+
+  for (t = 0; t < threads; ++t)
+  {
+    (void)pthread_join(tid[t], NULL);
+    total += job[t].ns;
+  }
+
+  return total / threads / ATOMIC_OPS;
+}
+
+struct atomicrun
+{
+  atomicfn   fn;
+  char      *base;
+  size_t     stride;
+  const int *cpus;
+  int        threads;
+};
+
+double runatomicjob(void *arg)
+{
+  struct atomicrun *run = arg;
+
+  return runatomic(run->fn, run->base, run->stride, run->cpus, run->threads);
+}
+
+// returns the median of sample()'s runatomic() runs, in ns per operation
+double atomiccost(const atomicfn fn, char *base, const size_t stride, const int *cpus, const int threads)
+{
+  struct atomicrun run = { fn, base, stride, cpus, threads };
+
+  return sample(runatomicjob, &run, NULL);
+}
+
+struct pingpong
+{
+  int       cpu;
+  uint64_t *flag;
+  uint64_t  parity; // 0 for the initiator, which moves first, 1 for the responder
+  int      *ready;  // start barrier shared by both sides
+  double    ns;
+};
+
+// bounces one cache line between two CPUs: each side waits for the other's
+// value and replies with the next one, so every step is one line transfer.
+// the clock starts once both sides are pinned, so thread start-up is left out
+void *pingpongthread(void *arg)
+{
+  struct pingpong *pp    = arg;
+  uint64_t         r     = 0;
+  double           start = 0.0;
+
+  (void)pin(pp->cpu);
+
+  (void)__atomic_add_fetch(pp->ready, 1, __ATOMIC_SEQ_CST);
+  while (__atomic_load_n(pp->ready, __ATOMIC_ACQUIRE) < 2)
+    CPURELAX();
+
+  start = nanotime();
+  for (r = 0; r < PINGPONG_ROUNDS; ++r)
+  {
+    while ((__atomic_load_n(pp->flag, __ATOMIC_ACQUIRE) & 1) != pp->parity)
+      CPURELAX();
+    __atomic_store_n(pp->flag, 2 * r + pp->parity + 1, __ATOMIC_RELEASE);
+  }
+  pp->ns = nanotime() - start;
+
+  return NULL;
+}
+
+// returns the one-way latency in nanoseconds of a line moving between CPUs
+double pingpong(const int a, const int b, uint64_t *flag)
+{
+  int             ready = 0;
+  struct pingpong pp[2] = {
+    { a, flag, 0, &ready, 0.0 },
+    { b, flag, 1, &ready, 0.0 },
+  };
+  pthread_t tid[2];
+
+  *flag = 0;
+  if (0 != pthread_create(&tid[0], NULL, pingpongthread, &pp[0]) ||
+      0 != pthread_create(&tid[1], NULL, pingpongthread, &pp[1]))
+  {
+    perror("pthread_create");
+    exit(1);
+  }
+  (void)pthread_join(tid[0], NULL);
+  (void)pthread_join(tid[1], NULL);
+
+  return pp[0].ns / (2.0 * PINGPONG_ROUNDS);
+}
+
+struct pingpongrun
+{
+  int       a;
+  int       b;
+  uint64_t *flag;
+};
+
+double runpingpong(void *arg)
+{
+  struct pingpongrun *run = arg;
+
+  return pingpong(run->a, run->b, run->flag);
+}
+
+// formats a measurement, or "-" if it was not taken
+char *nsstr(char *buf, const size_t len, const double ns)
+{
+  if (ns > 0.0)
+    (void)snprintf(buf, len, "%.2f", ns);
+  else
+    (void)snprintf(buf, len, "-");
+
+  return buf;
+}
+
+#define LOCKFREE(T) { #T, sizeof(T), atomic_is_lock_free(&(_Atomic T){ 0 }), __atomic_always_lock_free(sizeof(T), 0) }
+
+void printatomics()
+{
+  const char *majorline = ruler('=');
+  const char *minorline = ruler('-');
+
+  const struct
+  {
+    const char *name;
+    size_t      size;
+    bool        lockfree;
+    bool        always;
+  }
+  lockfree[] = {
+    LOCKFREE(bool),
+    LOCKFREE(char),
+    LOCKFREE(short),
+    LOCKFREE(int),
+    LOCKFREE(long),
+    LOCKFREE(long long),
+    LOCKFREE(intmax_t),
+    LOCKFREE(size_t),
+    LOCKFREE(intptr_t),
+    LOCKFREE(void *),
+  };
+
+  int       cpus[CPU_SETSIZE];
+  int       ncpu    = cpulist(cpus, CPU_SETSIZE);
+  int       threads = ncpu < ATOMIC_MAX_THREADS ? ncpu : ATOMIC_MAX_THREADS;
+  int       matrix  = ncpu < PINGPONG_MAX_CPUS ? ncpu : PINGPONG_MAX_CPUS;
+  bool      cx16    = hascx16();
+  char     *lines   = aligned_alloc(SHARING_STRIDE, SHARING_STRIDE * ATOMIC_MAX_THREADS);
+  double    near    = 0.0;
+  double    far     = 0.0;
+  double    ns      = 0.0;
+  double    c2cmin  = DBL_MAX;
+  double    c2cmax  = 0.0;
+  size_t    i       = 0;
+  int       a       = 0;
+  int       b       = 0;
+  char      cell[4][32];
+
+  if (NULL == lines)
+  {
+    perror("aligned_alloc");
+    return;
+  }
+  memset(lines, 0, SHARING_STRIDE * ATOMIC_MAX_THREADS);
+
+  puts(majorline);
+  printf("%*s\n", LINE_WIDTH - 2, "ATOMICS AND CACHE-LINE SHARING");
+  puts(majorline);
+
+  putchar('\n');
+  puts(minorline);
+  raprintf(LINE_WIDTH, "%*s: %5s %20s %20s\n", CSYM_WIDTH, "type", "bytes", "atomic_is_lock_free", "always_lock_free");
+  puts(minorline);
+  for (i = 0; i < sizeof(lockfree) / sizeof(*lockfree); ++i)
+    raprintf(LINE_WIDTH, "%*s: %5zu %20s %20s\n", CSYM_WIDTH, lockfree[i].name, lockfree[i].size,
+      lockfree[i].lockfree ? "yes" : "no", lockfree[i].always ? "yes" : "no");
+#if defined(__SIZEOF_INT128__)
+  raprintf(LINE_WIDTH, "%*s: %5zu %20s %20s\n", CSYM_WIDTH, "__int128", sizeof(__int128),
+    cx16 ? "cmpxchg16b" : "no", __atomic_always_lock_free(sizeof(__int128), 0) ? "yes" : "no");
+#endif
+  puts(minorline);
+
+  putchar('\n');
+  printf("\tns per operation on one line: 1 thread on cpu %d", cpus[0]);
+  if (threads > 1)
+    printf(", then %d threads on cpus %d..%d", threads, cpus[0], cpus[threads - 1]);
+  putchar('\n');
+  printf("\tcas is a compare-and-swap increment loop, counted per successful update\n");
+
+  putchar('\n');
+  puts(minorline);
+  raprintf(LINE_WIDTH, "%*s: %12s %12s %16s %16s\n", CSYM_WIDTH, "width",
+    "fetch_add", "cas", "contended add", "contended cas");
+  puts(minorline);
+  for (i = 0; i < sizeof(ATOMICWIDTHS) / sizeof(*ATOMICWIDTHS); ++i)
+  {
+    double add  = 0.0, cas  = 0.0;
+    double cadd = 0.0, ccas = 0.0;
+
+    if (NULL == ATOMICWIDTHS[i].add && !cx16)
+      continue;
+
+    memset(lines, 0, SHARING_STRIDE);
+    if (NULL != ATOMICWIDTHS[i].add)
+      add = atomiccost(ATOMICWIDTHS[i].add, lines, 0, cpus, 1);
+    cas = atomiccost(ATOMICWIDTHS[i].cas, lines, 0, cpus, 1);
+    if (threads > 1)
+    {
+      if (NULL != ATOMICWIDTHS[i].add)
+        cadd = atomiccost(ATOMICWIDTHS[i].add, lines, 0, cpus, threads);
+      ccas = atomiccost(ATOMICWIDTHS[i].cas, lines, 0, cpus, threads);
+    }
+
+    if (NULL != ATOMICWIDTHS[i].add)
+      publish(add, "atomic_add%d_ns", ATOMICWIDTHS[i].bits);
+    publish(cas, "atomic_cas%d_ns", ATOMICWIDTHS[i].bits);
+    raprintf(LINE_WIDTH, "%*s: %12s %12s %16s %16s\n", CSYM_WIDTH, ATOMICWIDTHS[i].name,
+      nsstr(cell[0], sizeof(cell[0]), add), nsstr(cell[1], sizeof(cell[1]), cas),
+      nsstr(cell[2], sizeof(cell[2]), cadd), nsstr(cell[3], sizeof(cell[3]), ccas));
+  }
+  puts(minorline);
+
+  if (threads < 2)
+  {
+    putchar('\n');
+    printf("\tonly one CPU is available; contention, core-to-core and false-sharing\n" \
+           "\tmeasurements need at least two\n");
+    printquality();
+    putchar('\n');
+    free(lines);
+    return;
+  }
+
+  putchar('\n');
+  printf("\tcore-to-core one-way cache-line latency in ns (%d round trips per pair)\n", PINGPONG_ROUNDS);
+  putchar('\n');
+  puts(minorline);
+  printf("%*s:", CSYM_WIDTH - 4, "cpu");
+  for (b = 0; b < matrix; ++b)
+    printf(" %5d", cpus[b]);
+  putchar('\n');
+  puts(minorline);
+  for (a = 0; a < matrix; ++a)
+  {
+    printf("%*d:", CSYM_WIDTH - 4, cpus[a]);
+    for (b = 0; b < matrix; ++b)
+    {
+      struct pingpongrun run = { cpus[a], cpus[b], (uint64_t *)lines };
+
+      if (a == b)
+      {
+        printf(" %5s", "-");
+        continue;
+      }
+      ns = sample(runpingpong, &run, NULL);
+      printf(" %5.0f", ns);
+      if (ns < c2cmin)
+        publish(c2cmin = ns, "c2c_min_ns");
+      if (ns > c2cmax)
+        publish(c2cmax = ns, "c2c_max_ns");
+      (void)fflush(stdout);
+    }
+    putchar('\n');
+  }
+  puts(minorline);
+
+  near = atomiccost(counterinc, lines, sizeof(uint64_t), cpus, threads);
+  memset(lines, 0, SHARING_STRIDE * ATOMIC_MAX_THREADS);
+  far  = atomiccost(counterinc, lines, SHARING_STRIDE, cpus, threads);
+
+  putchar('\n');
+  puts(minorline);
+  raprintf(LINE_WIDTH, "%*s: %12s %12s %12s\n", CSYM_WIDTH, "false sharing", "adjacent", "padded", "slowdown");
+  puts(minorline);
+  raprintf(LINE_WIDTH, "%*s: %9.2f ns %9.2f ns %11.1fx\n", CSYM_WIDTH, "private counter ++",
+    near, far, near / far);
+  publish(near / far, "false_sharing_x");
+  puts(minorline);
+  printf("\t%d threads each increment their own counter, 8 bytes apart or %d bytes apart\n",
+    threads, SHARING_STRIDE);
+
+  printquality();
+  putchar('\n');
+  free(lines);
+}
+
+#define STR(x)  #x
+#define XSTR(x) STR(x)
+
+// a feature macro the compiler did not predefine stringizes to its own name,
+// one it did define stringizes to "1"
+#define COMPILEDFOR(str) ('1' == (str)[0])
+
+#define FLOPS_ACCUMULATORS 12 // independent vector chains, enough to cover FMA latency
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#define XCR0_AVX    0x06 // XMM and YMM state enabled by the OS
+#define XCR0_AVX512 0xe6 // and also opmask and ZMM state
+
+// leaf 0x80000001 is the extended feature leaf
+#define ISA(name, leaf, sub, reg, bit, xcr0, macro) \
+  { name, leaf, sub, reg, bit, xcr0, XSTR(macro) }
+
+static const struct
+{
+  const char *name;
+  unsigned    leaf;
+  unsigned    subleaf;
+  char        reg;     // 'a', 'b', 'c' or 'd' for eax..edx
+  unsigned    bit;
+  unsigned    xcr0;    // OS-enabled register state the feature also needs
+  const char *macro;
+}
+ISAFEATURES[] = {
+  ISA("sse",             1, 0, 'd', 25, 0,           __SSE__),
+  ISA("sse2",            1, 0, 'd', 26, 0,           __SSE2__),
+  ISA("sse3",            1, 0, 'c',  0, 0,           __SSE3__),
+  ISA("ssse3",           1, 0, 'c',  9, 0,           __SSSE3__),
+  ISA("sse4.1",          1, 0, 'c', 19, 0,           __SSE4_1__),
+  ISA("sse4.2",          1, 0, 'c', 20, 0,           __SSE4_2__),
+  ISA("popcnt",          1, 0, 'c', 23, 0,           __POPCNT__),
+  ISA("lzcnt",  0x80000001, 0, 'c',  5, 0,           __LZCNT__),
+  ISA("movbe",           1, 0, 'c', 22, 0,           __MOVBE__),
+  ISA("pclmul",          1, 0, 'c',  1, 0,           __PCLMUL__),
+  ISA("aes",             1, 0, 'c', 25, 0,           __AES__),
+  ISA("sha",             7, 0, 'b', 29, 0,           __SHA__),
+  ISA("rdrnd",           1, 0, 'c', 30, 0,           __RDRND__),
+  ISA("rdseed",          7, 0, 'b', 18, 0,           __RDSEED__),
+  ISA("bmi",             7, 0, 'b',  3, 0,           __BMI__),
+  ISA("bmi2",            7, 0, 'b',  8, 0,           __BMI2__),
+  ISA("adx",             7, 0, 'b', 19, 0,           __ADX__),
+  ISA("avx",             1, 0, 'c', 28, XCR0_AVX,    __AVX__),
+  ISA("f16c",            1, 0, 'c', 29, XCR0_AVX,    __F16C__),
+  ISA("fma",             1, 0, 'c', 12, XCR0_AVX,    __FMA__),
+  ISA("avx2",            7, 0, 'b',  5, XCR0_AVX,    __AVX2__),
+  ISA("avxvnni",         7, 1, 'a',  4, XCR0_AVX,    __AVXVNNI__),
+  ISA("vaes",            7, 0, 'c',  9, XCR0_AVX,    __VAES__),
+  ISA("vpclmulqdq",      7, 0, 'c', 10, XCR0_AVX,    __VPCLMULQDQ__),
+  ISA("gfni",            7, 0, 'c',  8, 0,           __GFNI__),
+  ISA("avx512f",         7, 0, 'b', 16, XCR0_AVX512, __AVX512F__),
+  ISA("avx512cd",        7, 0, 'b', 28, XCR0_AVX512, __AVX512CD__),
+  ISA("avx512dq",        7, 0, 'b', 17, XCR0_AVX512, __AVX512DQ__),
+  ISA("avx512bw",        7, 0, 'b', 30, XCR0_AVX512, __AVX512BW__),
+  ISA("avx512vl",        7, 0, 'b', 31, XCR0_AVX512, __AVX512VL__),
+  ISA("avx512ifma",      7, 0, 'b', 21, XCR0_AVX512, __AVX512IFMA__),
+  ISA("avx512vbmi",      7, 0, 'c',  1, XCR0_AVX512, __AVX512VBMI__),
+  ISA("avx512vbmi2",     7, 0, 'c',  6, XCR0_AVX512, __AVX512VBMI2__),
+  ISA("avx512vnni",      7, 0, 'c', 11, XCR0_AVX512, __AVX512VNNI__),
+  ISA("avx512bitalg",    7, 0, 'c', 12, XCR0_AVX512, __AVX512BITALG__),
+  ISA("avx512vpopcntdq", 7, 0, 'c', 14, XCR0_AVX512, __AVX512VPOPCNTDQ__),
+  ISA("avx512bf16",      7, 1, 'a',  5, XCR0_AVX512, __AVX512BF16__),
+  ISA("avx512fp16",      7, 0, 'd', 23, XCR0_AVX512, __AVX512FP16__),
+};
+
+#define ISA_FEATURES (sizeof(ISAFEATURES) / sizeof(*ISAFEATURES))
+
+// reads XCR0, the register state the OS saves on context switch, which is
+// only readable (and AVX only usable) if the OS has set CR4.OSXSAVE
+unsigned long long xcr0()
+{
+  unsigned a = 0, b = 0, c = 0, d = 0;
+
+  if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & bit_OSXSAVE))
+    return 0;
+
+  __asm__ __volatile__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+
+  return ((unsigned long long)d << 32) | a;
+}
+
+bool cpuhas(const unsigned leaf, const unsigned subleaf, const char reg, const unsigned bit)
+{
+  unsigned r[4] = { 0, 0, 0, 0 };
+
+  if (__get_cpuid_max(leaf & 0x80000000, NULL) < leaf)
+    return false;
+
+  __cpuid_count(leaf, subleaf, r[0], r[1], r[2], r[3]);
+
+  return (r[reg - 'a'] >> bit) & 1;
+}
+
+// true if the CPU has the named feature and the OS has enabled its state
+bool isausable(const char *name)
+{
+  size_t i = 0;
+
+  for (i = 0; i < ISA_FEATURES; ++i)
+    if (0 == strcmp(name, ISAFEATURES[i].name))
+      return cpuhas(ISAFEATURES[i].leaf, ISAFEATURES[i].subleaf, ISAFEATURES[i].reg, ISAFEATURES[i].bit) &&
+        (xcr0() & ISAFEATURES[i].xcr0) == ISAFEATURES[i].xcr0;
+
+  return false;
+}
+
+#define HIDEV(x) __asm__ __volatile__("" : "+v"(x))
+
+#define REP12(s) s s s s s s s s s s s s
+
+// defines flops_<sfx>(n), timing n iterations of OP applied to each of
+// FLOPS_ACCUMULATORS independent vectors. the multiplier is one and the
+// addend zero, and every value is opaque, so values stay normal and the
+// identical chains can be neither folded nor merged.
+#define DEFINE_FLOPS(sfx, TARGET, V, SET1, OP)                              \
+  __attribute__((target(TARGET)))                                           \
+  double flops_##sfx(const size_t n)                                        \
+  {                                                                         \
+    V      b = SET1(1.0), c = SET1(0.0);                                    \
+    V      x0 = b, x1 = b, x2 = b, x3 = b, x4  = b, x5  = b;                \
+    V      x6 = b, x7 = b, x8 = b, x9 = b, x10 = b, x11 = b;                \
+    size_t i = 0;                                                           \
+    double start = 0.0;                                                     \
+    HIDEV(b); HIDEV(c);                                                     \
+    start = nanotime();                                                     \
+    for (i = 0; i < n; ++i)                                                 \
+    {                                                                       \
+      x0 = OP(x0); x1 = OP(x1); x2  = OP(x2);  x3  = OP(x3);                \
+      x4 = OP(x4); x5 = OP(x5); x6  = OP(x6);  x7  = OP(x7);                \
+      x8 = OP(x8); x9 = OP(x9); x10 = OP(x10); x11 = OP(x11);               \
+      HIDEV(x0); HIDEV(x1); HIDEV(x2);  HIDEV(x3);                          \
+      HIDEV(x4); HIDEV(x5); HIDEV(x6);  HIDEV(x7);                          \
+      HIDEV(x8); HIDEV(x9); HIDEV(x10); HIDEV(x11);                         \
+    }                                                                       \
+    return nanotime() - start;                                              \
+  }
+
+#define ADD128PS(x) _mm_add_ps(x, c)
+#define ADD128PD(x) _mm_add_pd(x, c)
+#define FMA128PS(x) _mm_fmadd_ps(x, b, c)
+#define FMA128PD(x) _mm_fmadd_pd(x, b, c)
+#define ADD256PS(x) _mm256_add_ps(x, c)
+#define ADD256PD(x) _mm256_add_pd(x, c)
+#define FMA256PS(x) _mm256_fmadd_ps(x, b, c)
+#define FMA256PD(x) _mm256_fmadd_pd(x, b, c)
+#define ADD512PS(x) _mm512_add_ps(x, c)
+#define ADD512PD(x) _mm512_add_pd(x, c)
+#define FMA512PS(x) _mm512_fmadd_ps(x, b, c)
+#define FMA512PD(x) _mm512_fmadd_pd(x, b, c)
+
+DEFINE_FLOPS(add128ps, "sse2",    __m128,  _mm_set1_ps,    ADD128PS)
+DEFINE_FLOPS(add128pd, "sse2",    __m128d, _mm_set1_pd,    ADD128PD)
+DEFINE_FLOPS(fma128ps, "fma",     __m128,  _mm_set1_ps,    FMA128PS)
+DEFINE_FLOPS(fma128pd, "fma",     __m128d, _mm_set1_pd,    FMA128PD)
+DEFINE_FLOPS(add256ps, "avx",     __m256,  _mm256_set1_ps, ADD256PS)
+DEFINE_FLOPS(add256pd, "avx",     __m256d, _mm256_set1_pd, ADD256PD)
+DEFINE_FLOPS(fma256ps, "avx,fma", __m256,  _mm256_set1_ps, FMA256PS)
+DEFINE_FLOPS(fma256pd, "avx,fma", __m256d, _mm256_set1_pd, FMA256PD)
+DEFINE_FLOPS(add512ps, "avx512f", __m512,  _mm512_set1_ps, ADD512PS)
+DEFINE_FLOPS(add512pd, "avx512f", __m512d, _mm512_set1_pd, ADD512PD)
+DEFINE_FLOPS(fma512ps, "avx512f", __m512,  _mm512_set1_ps, FMA512PS)
+DEFINE_FLOPS(fma512pd, "avx512f", __m512d, _mm512_set1_pd, FMA512PD)
+
+static const struct
+{
+  const char *name;
+  const char *needs;  // ISAFEATURES entry the kernel requires
+  size_t      flops;  // per iteration of one accumulator
+  double    (*run)(const size_t);
+}
+FLOPSKERNELS[] = {
+  { "128-bit add float",  "sse2",     4, flops_add128ps },
+  { "128-bit add double", "sse2",     2, flops_add128pd },
+  { "128-bit fma float",  "fma",      8, flops_fma128ps },
+  { "128-bit fma double", "fma",      4, flops_fma128pd },
+  { "256-bit add float",  "avx",      8, flops_add256ps },
+  { "256-bit add double", "avx",      4, flops_add256pd },
+  { "256-bit fma float",  "fma",     16, flops_fma256ps },
+  { "256-bit fma double", "fma",      8, flops_fma256pd },
+  { "512-bit add float",  "avx512f", 16, flops_add512ps },
+  { "512-bit add double", "avx512f",  8, flops_add512pd },
+  { "512-bit fma float",  "avx512f", 32, flops_fma512ps },
+  { "512-bit fma double", "avx512f", 16, flops_fma512pd },
+};
+
+#define NAMEDVECTOR(T, E) { #T, sizeof(T), _Alignof(T), #E, sizeof(T) / sizeof(E) }
+
+static const struct
+{
+  const char *name;
+  size_t      size;
+  size_t      align;
+  const char *element;
+  size_t      lanes;
+}
+NAMEDVECTORS[] = {
+  NAMEDVECTOR(__m128,  float),
+  NAMEDVECTOR(__m128d, double),
+  NAMEDVECTOR(__m128i, int32_t),
+  NAMEDVECTOR(__m256,  float),
+  NAMEDVECTOR(__m256d, double),
+  NAMEDVECTOR(__m256i, int32_t),
+  NAMEDVECTOR(__m512,  float),
+  NAMEDVECTOR(__m512d, double),
+  NAMEDVECTOR(__m512i, int32_t),
+};
+
+#endif
+
+#define VECTOR(E, W) E __attribute__((vector_size(W)))
+
+#define VECTORWIDTH(W)                                                      \
+  { W, _Alignof(VECTOR(int8_t, W)),                                         \
+    { sizeof(VECTOR(int8_t,  W)) / sizeof(int8_t),                          \
+      sizeof(VECTOR(int16_t, W)) / sizeof(int16_t),                         \
+      sizeof(VECTOR(int32_t, W)) / sizeof(int32_t),                         \
+      sizeof(VECTOR(int64_t, W)) / sizeof(int64_t),                         \
+      sizeof(VECTOR(float,   W)) / sizeof(float),                           \
+      sizeof(VECTOR(double,  W)) / sizeof(double) } }
+
+static const struct
+{
+  size_t size;
+  size_t align;
+  size_t lanes[6];
+}
+VECTORWIDTHS[] = {
+  VECTORWIDTH(8),
+  VECTORWIDTH(16),
+  VECTORWIDTH(32),
+  VECTORWIDTH(64),
+};
+
+struct flopsrun
+{
+  double (*run)(const size_t);
+  size_t n;
+};
+
+double runflops(void *arg)
+{
+  struct flopsrun *run = arg;
+
+  return run->run(run->n);
+}
+
+// returns the median run time of a kernel, with its iteration count doubled
+// until one run lasts at least BENCH_MIN_NS
+double medianrun(double (*run)(const size_t), size_t *n)
+{
+  struct flopsrun job = { run, 1024 };
+
+  while (run(job.n) < BENCH_MIN_NS && job.n < BENCH_MAX_ITER)
+    job.n *= 2;
+  *n = job.n;
+
+  return sample(runflops, &job, NULL);
+}
+
+void printsimd()
+{
+  const char *majorline = ruler('=');
+  const char *minorline = ruler('-');
+
+  size_t i   = 0;
+  size_t w   = 0;
+
+  puts(majorline);
+  printf("%*s\n", LINE_WIDTH - 2, "SIMD CAPABILITIES");
+  puts(majorline);
+
+#if defined(__x86_64__) || defined(__i386__)
+  {
+    unsigned long long state = xcr0();
+    double ghz  = cpughz();
+    double ns   = 0.0;
+    double gf   = 0.0;
+    double peak = 0.0;
+    size_t n    = 0;
+    bool   cpu  = false;
+    bool   os   = false;
+    bool   bin  = false;
+    bool   bad  = false;
+
+    putchar('\n');
+    printf("\tcpu: reported by cpuid; os: register state enabled in XCR0 (%#llx);\n" \
+           "\tcompiled: predefined by the compiler for this binary\n", state);
+
+    putchar('\n');
+    puts(minorline);
+    raprintf(LINE_WIDTH, "%*s: %6s %6s %9s  %-38s\n", CSYM_WIDTH, "extension", "cpu", "os", "compiled", "");
+    puts(minorline);
+    for (i = 0; i < ISA_FEATURES; ++i)
+    {
+      cpu = cpuhas(ISAFEATURES[i].leaf, ISAFEATURES[i].subleaf, ISAFEATURES[i].reg, ISAFEATURES[i].bit);
+      os  = (state & ISAFEATURES[i].xcr0) == ISAFEATURES[i].xcr0;
+      bin = COMPILEDFOR(ISAFEATURES[i].macro);
+      bad = bad || (bin && !(cpu && os));
+
+      raprintf(LINE_WIDTH, "%*s: %6s %6s %9s  %-38s\n", CSYM_WIDTH, ISAFEATURES[i].name,
+        cpu ? "yes" : "no", 0 == ISAFEATURES[i].xcr0 ? "-" : os ? "yes" : "no", bin ? "yes" : "no",
+        bin && !(cpu && os) ? "MISSING: binary may fault with SIGILL" :
+        !bin && cpu && os   ? "unused: only via runtime dispatch" : "");
+    }
+    puts(minorline);
+    if (bad)
+      printf("\tWARNING: this binary was compiled for extensions this host cannot execute\n");
+
+    putchar('\n');
+    puts(minorline);
+    raprintf(LINE_WIDTH, "%*s: %6s %6s %8s %6s\n", CSYM_WIDTH, "intrinsic type", "bytes", "align", "element", "lanes");
+    puts(minorline);
+    for (i = 0; i < sizeof(NAMEDVECTORS) / sizeof(*NAMEDVECTORS); ++i)
+      raprintf(LINE_WIDTH, "%*s: %6zu %6zu %8s %6zu\n", CSYM_WIDTH, NAMEDVECTORS[i].name,
+        NAMEDVECTORS[i].size, NAMEDVECTORS[i].align, NAMEDVECTORS[i].element, NAMEDVECTORS[i].lanes);
+    puts(minorline);
+
+    putchar('\n');
+    printf("\tpeak arithmetic rate with %d independent vector accumulators\n", FLOPS_ACCUMULATORS);
+    putchar('\n');
+    puts(minorline);
+    raprintf(LINE_WIDTH, "%*s: %10s %12s\n", CSYM_WIDTH, "kernel", "GFLOP/s", "FLOP/cycle");
+    puts(minorline);
+    for (i = 0; i < sizeof(FLOPSKERNELS) / sizeof(*FLOPSKERNELS); ++i)
+    {
+      if (!isausable(FLOPSKERNELS[i].needs))
+      {
+        raprintf(LINE_WIDTH, "%*s: %10s %12s\n", CSYM_WIDTH, FLOPSKERNELS[i].name, "-", "-");
+        continue;
+      }
+      ns = medianrun(FLOPSKERNELS[i].run, &n);
+      gf = (double)n * FLOPS_ACCUMULATORS * FLOPSKERNELS[i].flops / ns;
+      raprintf(LINE_WIDTH, "%*s: %10.2f %12.2f\n", CSYM_WIDTH, FLOPSKERNELS[i].name, gf, gf / ghz);
+      if (gf > peak)
+        publish(peak = gf, "peak_gflops");
+    }
+    puts(minorline);
+  }
+#elif defined(__linux__)
+  {
+    unsigned long hwcap = getauxval(AT_HWCAP);
+
+    putchar('\n');
+    printf("\tAT_HWCAP: %#lx, AT_HWCAP2: %#lx (see asm/hwcap.h for this architecture)\n",
+      hwcap, getauxval(AT_HWCAP2));
+#if defined(__aarch64__)
+    putchar('\n');
+    puts(minorline);
+    raprintf(LINE_WIDTH, "%*s: %6s %9s\n", CSYM_WIDTH, "extension", "cpu", "compiled");
+    puts(minorline);
+    raprintf(LINE_WIDTH, "%*s: %6s %9s\n", CSYM_WIDTH, "asimd",
+      hwcap & HWCAP_ASIMD ? "yes" : "no", COMPILEDFOR(XSTR(__ARM_NEON)) ? "yes" : "no");
+#if defined(HWCAP_SVE)
+    raprintf(LINE_WIDTH, "%*s: %6s %9s\n", CSYM_WIDTH, "sve",
+      hwcap & HWCAP_SVE ? "yes" : "no", COMPILEDFOR(XSTR(__ARM_FEATURE_SVE)) ? "yes" : "no");
+#endif
+    puts(minorline);
+#endif
+  }
+#endif
+
+  putchar('\n');
+  puts(minorline);
+  raprintf(LINE_WIDTH, "%*s: %6s %7s %7s %7s %7s %7s %7s\n", CSYM_WIDTH, "vector_size(N)",
+    "align", "int8", "int16", "int32", "int64", "float", "double");
+  puts(minorline);
+  for (w = 0; w < sizeof(VECTORWIDTHS) / sizeof(*VECTORWIDTHS); ++w)
+    raprintf(LINE_WIDTH, "%*zu: %6zu %7zu %7zu %7zu %7zu %7zu %7zu\n", CSYM_WIDTH, VECTORWIDTHS[w].size,
+      VECTORWIDTHS[w].align, VECTORWIDTHS[w].lanes[0], VECTORWIDTHS[w].lanes[1], VECTORWIDTHS[w].lanes[2],
+      VECTORWIDTHS[w].lanes[3], VECTORWIDTHS[w].lanes[4], VECTORWIDTHS[w].lanes[5]);
+  puts(minorline);
+  printf("\tlanes per element type; alignment is capped by what the compiled target supports\n");
+
+  printquality();
+  putchar('\n');
+}
+
+#define FENV_CALLS (1UL << 20) // rounding-mode calls timed per measurement
+
+#if defined(__x86_64__) || defined(__SSE2_MATH__)
+#define MXCSR_DAZ 0x0040 // denormal inputs are treated as zero
+#define MXCSR_FTZ 0x8000 // denormal results are flushed to zero
+#endif
+
+enum { OPERAND_NORMAL, OPERAND_SUBNORMAL, OPERAND_ZERO, OPERAND_COUNT };
+
+static const char *OPERANDNAME[OPERAND_COUNT] = { "normal", "subnormal", "zero" };
+
+// multiply-add with an opaque multiplier of one; y - y is an opaque zero that
+// is hoisted out of the loop, so x keeps its operand class on every step
+#define EXPR_MADD(x, y) ((x) * (y) + ((y) - (y)))
+
+// defines denormal_<sfx>(operand, kind, n) with the signature of the cost
+// kernels, so that costof() can time a multiply-add chain whose operands are
+// normal, subnormal (a quarter of the smallest normal) or zero
+#define DEFINE_DENORMAL(sfx, T, HIDE, MIN)                                  \
+  double denormal_##sfx(const int operand, const int kind, const size_t n)  \
+  {                                                                         \
+    double ns = 0.0;                                                        \
+    T      x0 = OPERAND_NORMAL    == operand ? (T)1.5 :                     \
+                OPERAND_SUBNORMAL == operand ? (T)(MIN) / 4 : (T)0;         \
+    (void)kind;                                                             \
+    COST_KERNEL(T, HIDE, COST_LATENCY, n, x0, 1, EXPR_MADD, ns);            \
+    return ns;                                                              \
+  }
+
+DEFINE_DENORMAL(float,   float,       OPAQUE_FP, FLT_MIN)
+DEFINE_DENORMAL(double,  double,      OPAQUE_FP, DBL_MIN)
+DEFINE_DENORMAL(ldouble, long double, OPAQUE_LD, LDBL_MIN)
+
+static const struct
+{
+  const char *name;
+  costfn      cost;
+  bool        mxcsr;  // whether FTZ/DAZ in MXCSR applies to this type
+}
+DENORMALTYPES[] = {
+#if defined(__x86_64__) || defined(__SSE2_MATH__)
+  { "float",       denormal_float,   true  },
+  { "double",      denormal_double,  true  },
+  { "long double", denormal_ldouble, false }, // x87 has no flush-to-zero
+#else
+  { "float",       denormal_float,   false },
+  { "double",      denormal_double,  false },
+  { "long double", denormal_ldouble, false },
+#endif
+};
+
+// returns the nanoseconds per call of fesetround, alternating between the
+// two modes arg points at if they differ
+double roundswitch(void *arg)
+{
+  const int *mode  = arg;
+  size_t     i     = 0;
+  double     start = nanotime();
+
+  for (i = 0; i < FENV_CALLS; i += 2)
+  {
+    (void)fesetround(mode[0]);
+    (void)fesetround(mode[1]);
+  }
+
+  return (nanotime() - start) / FENV_CALLS;
+}
+
+double roundquery(void *arg)
+{
+  size_t i     = 0;
+  int    mode  = 0;
+  double start = nanotime();
+
+  (void)arg;
+
+  // the memory clobber keeps the pure call from being hoisted
+  for (i = 0; i < FENV_CALLS; ++i)
+  {
+    mode = fegetround();
+    OPAQUE(mode);
+    CLOBBER();
+  }
+
+  return (nanotime() - start) / FENV_CALLS;
+}
+
+void printdenormal()
+{
+  const char *majorline = ruler('=');
+  const char *minorline = ruler('-');
+
+  double ns[OPERAND_COUNT];
+  double ghz     = cpughz();
+  double penalty = 0.0;
+  size_t t       = 0;
+  int    mode    = 0;
+  int    op      = 0;
+  int    save    = fegetround();
+  char   cell[32];
+
+  puts(majorline);
+  printf("%*s\n", LINE_WIDTH - 2, "SUBNORMAL AND ROUNDING-MODE COSTS");
+  puts(majorline);
+
+  putchar('\n');
+  printf("\tdependent multiply-add chain, ns per multiply-add (cycles at %.2f GHz)\n" \
+         "\tpenalty is subnormal over normal; ftz+daz sets MXCSR flush-to-zero and\n" \
+         "\tdenormals-are-zero, which only SSE arithmetic (not x87) honors\n", ghz);
+
+  putchar('\n');
+  puts(minorline);
+  printf("%*s: %8s %16s %16s %16s %8s\n", CSYM_WIDTH, "type", "mode",
+    OPERANDNAME[OPERAND_NORMAL], OPERANDNAME[OPERAND_SUBNORMAL], OPERANDNAME[OPERAND_ZERO], "penalty");
+  puts(minorline);
+  for (t = 0; t < sizeof(DENORMALTYPES) / sizeof(*DENORMALTYPES); ++t)
+  {
+    for (mode = 0; mode < 2; ++mode)
+    {
+#if defined(__x86_64__) || defined(__SSE2_MATH__)
+      unsigned csr = _mm_getcsr();
+      if (1 == mode)
+      {
+        if (!DENORMALTYPES[t].mxcsr)
+          continue;
+        _mm_setcsr(csr | MXCSR_FTZ | MXCSR_DAZ);
+      }
+#else
+      if (1 == mode)
+        continue;
+#endif
+      for (op = 0; op < OPERAND_COUNT; ++op)
+        ns[op] = costof(DENORMALTYPES[t].cost, op, COST_LATENCY);
+#if defined(__x86_64__) || defined(__SSE2_MATH__)
+      _mm_setcsr(csr);
+#endif
+
+      printf("%*s%c %8s", CSYM_WIDTH, 0 == mode ? DENORMALTYPES[t].name : "", 0 == mode ? ':' : ' ',
+        0 == mode ? "default" : "ftz+daz");
+      for (op = 0; op < OPERAND_COUNT; ++op)
+      {
+        (void)snprintf(cell, sizeof(cell), "%.2f (%.0f)", ns[op], ns[op] * ghz);
+        printf(" %16s", cell);
+      }
+      printf(" %7.1fx\n", ns[OPERAND_SUBNORMAL] / ns[OPERAND_NORMAL]);
+      if (0 == mode && ns[OPERAND_SUBNORMAL] / ns[OPERAND_NORMAL] > penalty)
+        publish(penalty = ns[OPERAND_SUBNORMAL] / ns[OPERAND_NORMAL], "subnormal_penalty_x");
+    }
+  }
+  puts(minorline);
+
+  putchar('\n');
+  puts(minorline);
+  raprintf(LINE_WIDTH, "%*s: %12s %12s\n", CSYM_WIDTH, "rounding mode call", "ns/call", "cycles/call");
+  puts(minorline);
+  {
+    int    same[2] = { FE_TONEAREST, FE_TONEAREST };
+    double get     = sample(roundquery, NULL, NULL);
+    double set     = sample(roundswitch, same, NULL);
+#if defined(FE_UPWARD)
+    int    flip[2] = { FE_TONEAREST, FE_UPWARD };
+    double swap    = sample(roundswitch, flip, NULL);
+#endif
+    raprintf(LINE_WIDTH, "%*s: %12.2f %12.1f\n", CSYM_WIDTH, "fegetround", get, get * ghz);
+    raprintf(LINE_WIDTH, "%*s: %12.2f %12.1f\n", CSYM_WIDTH, "fesetround (same)", set, set * ghz);
+#if defined(FE_UPWARD)
+    raprintf(LINE_WIDTH, "%*s: %12.2f %12.1f\n", CSYM_WIDTH, "fesetround (switch)", swap, swap * ghz);
+#endif
+  }
+  puts(minorline);
+
+  (void)fesetround(save);
+
+  printquality();
+  putchar('\n');
+}
+
+#define VM_MAX_BYTES (1UL << 30) // buffer mapped by each configuration, if free
+#define VM_HUGE      (2UL << 20) // alignment that lets THP back the whole buffer
+
+enum { VM_SMALL, VM_HUGEPAGE, VM_POPULATE, VM_CONFIGS };
+
+static const char *VMCONFIG[VM_CONFIGS] = {
+  "4 KiB pages", "MADV_HUGEPAGE", "prefaulted 4 KiB",
+};
+
+// VMCONFIG as published value names; the prefaulted one keeps the name it
+// had when it was mapped with MAP_POPULATE
+static const char *VMKEY[VM_CONFIGS] = {
+  "small_pages", "madv_hugepage", "map_populate",
+};
+
+// populates every page of buf up front, as MAP_POPULATE would, but only
+// once the huge page advice is in place, so that it applies to the pages
+void prefault(char *buf, const size_t bytes, const size_t page)
+{
+  size_t off = 0;
+
+#if defined(MADV_POPULATE_WRITE)
+  if (0 == madvise(buf, bytes, MADV_POPULATE_WRITE))
+    return;
+#endif
+  for (off = 0; off < bytes; off += page)
+    buf[off] = 1;
+}
+
+// returns the kB of the mapping containing addr that are backed by
+// transparent huge pages, according to /proc/self/smaps
+size_t anonhuge(const void *addr)
+{
+  FILE     *smaps = fopen("/proc/self/smaps", "r");
+  char      line[256];
+  uintptr_t lo    = 0;
+  uintptr_t hi    = 0;
+  bool      found = false;
+  size_t    kb    = 0;
+
+  if (NULL == smaps)
+    return 0;
+
+  while (NULL != fgets(line, sizeof(line), smaps))
+  {
+    // only mapping header lines start with an address range; the field
+    // lines start with a name, which cannot be followed by '-'
+    if (2 == sscanf(line, "%" SCNxPTR "-%" SCNxPTR, &lo, &hi))
+      found = lo <= (uintptr_t)addr && (uintptr_t)addr < hi;
+    else if (found && 1 == sscanf(line, "AnonHugePages: %zu kB", &kb))
+      break;
+  }
+  fclose(smaps);
+
+  return found ? kb : 0;
+}
+
+void printvm()
+{
+  const char *majorline = ruler('=');
+  const char *minorline = ruler('-');
+
+  size_t page    = (size_t)sysconf(_SC_PAGESIZE);
+  size_t bytes   = (size_t)sysconf(_SC_AVPHYS_PAGES) * page / 4;
+  size_t stride  = cachelinesize();
+  double ghz     = cpughz();
+  DIR   *dir     = NULL;
+  struct dirent *ent = NULL;
+  char   line[256];
+  char   cell[32];
+  size_t kb      = 0;
+  size_t huge    = 0;
+  int    config  = 0;
+
+  if (bytes > VM_MAX_BYTES)
+    bytes = VM_MAX_BYTES;
+  bytes = bytes / VM_HUGE * VM_HUGE;
+
+  puts(majorline);
+  printf("%*s\n", LINE_WIDTH - 2, "VIRTUAL MEMORY");
+  puts(majorline);
+
+  putchar('\n');
+  puts(minorline);
+  printf("%*s: %s\n", CSYM_WIDTH, "page size", sizestr(cell, sizeof(cell), page));
+  publish((double)page, "page_size");
+  if (NULL != (dir = opendir("/sys/kernel/mm/hugepages")))
+  {
+    while (NULL != (ent = readdir(dir)))
+      if (1 == sscanf(ent->d_name, "hugepages-%zukB", &kb))
+        printf("%*s: %s\n", CSYM_WIDTH, "huge page size", sizestr(cell, sizeof(cell), kb << 10));
+    closedir(dir);
+  }
+  if (0 != (huge = hugepagesize()))
+    publish((double)huge, "hugepage_size");
+  printf("%*s: %s\n", CSYM_WIDTH, "THP enabled",
+    readline("/sys/kernel/mm/transparent_hugepage/enabled", line, sizeof(line)) ? line : "not available");
+  printf("%*s: %s\n", CSYM_WIDTH, "THP defrag",
+    readline("/sys/kernel/mm/transparent_hugepage/defrag", line, sizeof(line)) ? line : "not available");
+  puts(minorline);
+
+  putchar('\n');
+  printf("\teach configuration maps %s, touches one byte per %s page, then\n" \
+         "\tchases a random pointer chain through it (ns per dependent load)\n",
+    sizestr(cell, sizeof(cell), bytes), sizestr(line, sizeof(line), page));
+
+  putchar('\n');
+  puts(minorline);
+  raprintf(LINE_WIDTH, "%*s: %9s %9s %11s %9s %9s %9s\n", CSYM_WIDTH, "configuration",
+    "mmap ms", "touch ms", "ns per 4K", "THP MiB", "ns/load", "cyc/load");
+  puts(minorline);
+  for (config = 0; config < VM_CONFIGS; ++config)
+  {
+    char  *map    = NULL;
+    char  *buf    = NULL;
+    void **head   = NULL;
+    size_t off    = 0;
+    double start  = 0.0;
+    double mapped = 0.0;
+    double faults = 0.0;
+    double best   = 0.0;
+
+    start = nanotime();
+    map   = mmap(NULL, bytes + VM_HUGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == map)
+    {
+      perror("mmap");
+      return;
+    }
+    buf = (char *)(((uintptr_t)map + VM_HUGE - 1) & ~(uintptr_t)(VM_HUGE - 1));
+    (void)madvise(buf, bytes, VM_HUGEPAGE == config ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+    if (VM_POPULATE == config)
+      prefault(buf, bytes, page);
+    mapped = nanotime() - start;
+
+    start = nanotime();
+    for (off = 0; off < bytes; off += page)
+      buf[off] = 1;
+    faults = nanotime() - start;
+
+    head = buildchase(buf, bytes, stride);
+    (void)chase(head, MEMORY_LOADS);
+    best = sample(runchase, head, NULL);
+
+    raprintf(LINE_WIDTH, "%*s: %9.2f %9.2f %11.1f %9zu %9.2f %9.1f\n", CSYM_WIDTH, VMCONFIG[config],
+      mapped / 1.0e6, faults / 1.0e6, (mapped + faults) / (bytes >> 12),
+      anonhuge(buf) >> 10, best / MEMORY_LOADS, best / MEMORY_LOADS * ghz);
+    publish((mapped + faults) / (bytes >> 12), "%s_ns_per_4k", VMKEY[config]);
+    (void)fflush(stdout);
+
+    (void)munmap(map, bytes + VM_HUGE);
+  }
+  puts(minorline);
+  printf("\tns per 4K is the mmap and first-touch time per 4 KiB of buffer; THP MiB is the\n" \
+         "\tpart of the buffer the kernel actually backed with transparent huge pages\n");
+
+  printquality();
+  putchar('\n');
+}
+
+// writes all of buf, retrying on short writes and signal interruptions
+bool writeall(const int fd, const char *buf, size_t len)
+{
+  ssize_t n = 0;
+
+  while (len > 0)
+  {
+    if ((n = write(fd, buf, len)) < 0)
+    {
+      if (EINTR == errno)
+        continue;
+      return false;
+    }
+    buf += n;
+    len -= (size_t)n;
+  }
+
+  return true;
+}
+
+// renders up to DUMP_LINE_BYTES bytes as one fixed-width line:
+//   offset: binary digits | hex digits | octal digits | text
+// padding the columns of a short final line, and returns the end of it
+char *dumpline(char *out, const unsigned char *in, const size_t n, const uint64_t offset)
+{
+  int    shift = offset >> 32 ? 60 : 28;
+  size_t i     = 0;
+
+  for (; shift >= 0; shift -= 4)
+    *out++ = HEXTAB[(offset >> shift) & 15][1];
+  *out++ = ':';
+
+  for (i = 0; i < DUMP_LINE_BYTES; ++i, out += 9)
+  {
+    out[0] = ' ';
+    if (i < n)
+      memcpy(out + 1, BINTAB[in[i]], 8);
+    else
+      memset(out + 1, ' ', 8);
+  }
+
+  *out++ = ' ';
+  *out++ = ' ';
+  for (i = 0; i < DUMP_LINE_BYTES; ++i, out += 2)
+  {
+    if (i < n)
+      memcpy(out, HEXTAB[in[i]], 2);
+    else
+      memset(out, ' ', 2);
+  }
+
+  *out++ = ' ';
+  for (i = 0; i < DUMP_LINE_BYTES; ++i, out += 4)
+  {
+    out[0] = ' ';
+    if (i < n)
+      memcpy(out + 1, OCTTAB[in[i]], 3);
+    else
+      memset(out + 1, ' ', 3);
+  }
+
+  *out++ = ' ';
+  *out++ = ' ';
+  for (i = 0; i < n; ++i)
+    *out++ = TXTTAB[in[i]];
+  *out++ = '\n';
+
+  return out;
+}
+
+// widest line dumpline() can produce
+#define DUMP_LINE_MAX (16 + 1 + 9 * DUMP_LINE_BYTES + 2 + 2 * DUMP_LINE_BYTES + 1 + 4 * DUMP_LINE_BYTES + 2 + DUMP_LINE_BYTES + 1)
+
+// output buffer shared by the filters, flushed to stdout with one write()
+struct sink
+{
+  char  *buf;
+  size_t len;
+};
+
+// flushes the sink. returns false if standard output fails.
+bool sinkflush(struct sink *out)
+{
+  if (!writeall(STDOUT_FILENO, out->buf, out->len))
+  {
+    if (EPIPE != errno)
+      perror("write");
+    return false;
+  }
+  out->len = 0;
+
+  return true;
+}
+
+// makes room for need more bytes, flushing when the buffer would overflow
+bool sinkroom(struct sink *out, const size_t need)
+{
+  return out->len + need <= DUMP_OUTBUF || sinkflush(out);
+}
+
+// consumes one block of input; returns false to stop the stream
+typedef bool (*blockfn)(void *ctx, const unsigned char *in, const size_t len);
+
+// feeds a file ("-" for standard input) to block(). regular files are mapped
+// and passed whole; anything else is read in DUMP_CHUNK blocks that are
+// filled completely before they are passed on, so only the last is short.
+bool readstream(const char *path, const blockfn block, void *ctx)
+{
+  int            fd    = 0 == strcmp(path, "-") ? STDIN_FILENO : open(path, O_RDONLY);
+  unsigned char *map   = MAP_FAILED;
+  unsigned char *chunk = NULL;
+  size_t         have  = 0;
+  ssize_t        n     = 0;
+  struct stat    st;
+  bool           ok    = true;
+
+  if (fd < 0)
+  {
+    perror(path);
+    return false;
+  }
+
+  if (0 == fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0)
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  if (MAP_FAILED != map)
+  {
+    (void)madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+    ok = block(ctx, map, (size_t)st.st_size);
+    (void)munmap(map, (size_t)st.st_size);
+  }
+  else if (NULL != (chunk = malloc(DUMP_CHUNK)))
+  {
+    do
+    {
+      for (have = 0; have < DUMP_CHUNK; have += (size_t)n)
+      {
+        if ((n = read(fd, chunk + have, DUMP_CHUNK - have)) < 0 && EINTR == errno)
+          n = 0;
+        else if (n <= 0)
+          break;
+      }
+      if (n < 0)
+      {
+        perror(path);
+        ok = false;
+      }
+      else if (have > 0)
+      {
+        ok = block(ctx, chunk, have);
+      }
+    }
+    while (ok && n > 0);
+    free(chunk);
+  }
+  else
+  {
+    perror("malloc");
+    ok = false;
+  }
+
+  if (STDIN_FILENO != fd)
+    close(fd);
+
+  return ok;
+}
+
+struct dump
+{
+  struct sink out;
+  uint64_t    offset;
+};
+
+// renders a block of input as dump lines
+bool dumpblock(void *ctx, const unsigned char *in, const size_t len)
+{
+  struct dump *dump = ctx;
+  size_t       left = len;
+  size_t       n    = 0;
+
+  for (; left > 0; in += n, left -= n, dump->offset += n)
+  {
+    if (!sinkroom(&dump->out, DUMP_LINE_MAX))
+      return false;
+    n             = left < DUMP_LINE_BYTES ? left : DUMP_LINE_BYTES;
+    dump->out.len = (size_t)(dumpline(dump->out.buf + dump->out.len, in, n, dump->offset) - dump->out.buf);
+  }
+
+  return true;
+}
+
+// dumps a file ("-" for standard input) as binary, hex, octal and text
+bool dumpbits(const char *path)
+{
+  struct dump dump = { { NULL, 0 }, 0 };
+  bool        ok   = false;
+
+  bittables();
+  if (NULL == (dump.out.buf = malloc(DUMP_OUTBUF)))
+  {
+    perror("malloc");
+    return false;
+  }
+
+  ok = readstream(path, dumpblock, &dump) && sinkflush(&dump.out);
+  free(dump.out.buf);
+
+  return ok;
+}
+
+#define DECODE_TOKEN_MAX 128 // longest number --decode accepts on a line
+#define DECODE_LINE_MAX  384 // widest line decodeline() renders after the token
+
+enum
+{
+  DECODE_FLOAT,
+  DECODE_SIGNED,
+  DECODE_UNSIGNED,
+};
+
+struct decodetype
+{
+  const char *name;
+  int         kind;
+  size_t      size;
+  int         expbits;  // DECODE_FLOAT only
+  int         mantbits; // DECODE_FLOAT only
+};
+
+static const struct decodetype DECODETYPES[] = {
+  { "float",  DECODE_FLOAT,    sizeof(float),  8,  23 },
+  { "double", DECODE_FLOAT,    sizeof(double), 11, 52 },
+  { "int8",   DECODE_SIGNED,   1,              0,  0  },
+  { "int16",  DECODE_SIGNED,   2,              0,  0  },
+  { "int32",  DECODE_SIGNED,   4,              0,  0  },
+  { "int64",  DECODE_SIGNED,   8,              0,  0  },
+  { "uint8",  DECODE_UNSIGNED, 1,              0,  0  },
+  { "uint16", DECODE_UNSIGNED, 2,              0,  0  },
+  { "uint32", DECODE_UNSIGNED, 4,              0,  0  },
+  { "uint64", DECODE_UNSIGNED, 8,              0,  0  },
+};
+
+// exact powers of ten for the fast decimal paths
+static const double POW10[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+static const float POW10F[] = {
+  1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+};
+
+struct decode
+{
+  struct sink              out;
+  const struct decodetype *type;
+  locale_t                 clocale;  // for the strtod fallback
+  char                     carry[DECODE_TOKEN_MAX + 1];
+  size_t                   carried;  // bytes of a line split across blocks
+  char                     scratch[DECODE_TOKEN_MAX + 1];
+  size_t                   trailing; // raw bytes short of a whole record
+};
+
+// looks up a --decode type by name, with or without a trailing "_t"
+const struct decodetype *decodetype(const char *name)
+{
+  size_t n = strlen(name);
+  size_t i = 0;
+
+  if (n > 2 && 0 == strcmp(name + n - 2, "_t"))
+    n -= 2;
+
+  for (i = 0; i < sizeof(DECODETYPES) / sizeof(*DECODETYPES); ++i)
+  {
+    if (n == strlen(DECODETYPES[i].name) && 0 == strncmp(name, DECODETYPES[i].name, n))
+      return &DECODETYPES[i];
+  }
+
+  return NULL;
+}
+
+// splits a plain decimal ([-+]digits[.digits][e[-+]digits]) into a sign, a
+// significand of at most 19 digits and a power of ten. returns false for
+// anything else (inf, nan, hex, longer significands) so the caller can fall
+// back to a full conversion.
+bool scandecimal(const char *s, const char *end, bool *neg, uint64_t *sig, int *exp10)
+{
+  int  digits = 0; // significant digits taken into sig
+  int  frac   = 0;
+  int  exp    = 0;
+  bool any    = false;
+  bool eneg   = false;
+
+  *neg = false;
+  *sig = 0;
+  if (s < end && ('-' == *s || '+' == *s))
+    *neg = '-' == *s++;
+
+  for (; s < end && *s >= '0' && *s <= '9'; ++s, any = true)
+  {
+    if ((*sig > 0 || '0' != *s) && ++digits > 19)
+      return false;
+    *sig = *sig * 10 + (uint64_t)(*s - '0');
+  }
+  if (s < end && '.' == *s)
+  {
+    for (++s; s < end && *s >= '0' && *s <= '9'; ++s, ++frac, any = true)
+    {
+      if ((*sig > 0 || '0' != *s) && ++digits > 19)
+        return false;
+      *sig = *sig * 10 + (uint64_t)(*s - '0');
+    }
+  }
+  if (!any)
+    return false;
+
+  if (s < end && ('e' == *s || 'E' == *s))
+  {
+    if (++s < end && ('-' == *s || '+' == *s))
+      eneg = '-' == *s++;
+    if (s == end || *s < '0' || *s > '9')
+      return false;
+    for (; s < end && *s >= '0' && *s <= '9'; ++s)
+    {
+      if (exp < 100000)
+        exp = exp * 10 + (*s - '0');
+    }
+  }
+
+  *exp10 = (eneg ? -exp : exp) - frac;
+
+  return s == end;
+}
+
+// converts a decimal token to double. significands and powers of ten that
+// are both exact in a double give a correctly rounded result from a single
+// multiply or divide; everything else goes through strtod_l in the C locale.
+bool parsedouble(struct decode *dec, const char *s, const size_t len, double *value)
+{
+  bool     neg   = false;
+  uint64_t sig   = 0;
+  int      exp10 = 0;
+  char    *end   = NULL;
+  double   v     = 0.0;
+
+  if (scandecimal(s, s + len, &neg, &sig, &exp10) && sig <= (1ULL << 53))
+  {
+    v = (double)sig;
+    if (0 == sig)
+      exp10 = 0;
+    // move surplus powers of ten into the significand while it stays exact
+    for (; exp10 > 22 && v < 1e15; --exp10)
+      v *= 10;
+    if (exp10 >= -22 && exp10 <= 22 && v <= 0x1p53)
+    {
+      v      = exp10 < 0 ? v / POW10[-exp10] : v * POW10[exp10];
+      *value = neg ? -v : v;
+      return true;
+    }
+  }
+
+  memcpy(dec->scratch, s, len);
+  dec->scratch[len] = '\0';
+  *value            = strtod_l(dec->scratch, &end, dec->clocale);
+
+  return end == dec->scratch + len;
+}
+
+// converts a decimal token to float, as parsedouble() does for double
+bool parsefloat(struct decode *dec, const char *s, const size_t len, float *value)
+{
+  bool     neg   = false;
+  uint64_t sig   = 0;
+  int      exp10 = 0;
+  char    *end   = NULL;
+  float    v     = 0.0f;
+
+  if (scandecimal(s, s + len, &neg, &sig, &exp10) && sig <= (1ULL << 24))
+  {
+    if (0 == sig)
+      exp10 = 0;
+    if (exp10 >= -10 && exp10 <= 10)
+    {
+      v      = (float)sig;
+      v      = exp10 < 0 ? v / POW10F[-exp10] : v * POW10F[exp10];
+      *value = neg ? -v : v;
+      return true;
+    }
+  }
+
+  memcpy(dec->scratch, s, len);
+  dec->scratch[len] = '\0';
+  *value            = strtof_l(dec->scratch, &end, dec->clocale);
+
+  return end == dec->scratch + len;
+}
+
+// converts a decimal integer token, rejecting values out of range of type
+bool parseint(const struct decodetype *type, const char *s, const size_t len, uint64_t *bits)
+{
+  const char *end  = s + len;
+  unsigned    w    = 8 * (unsigned)type->size;
+  uint64_t    max  = 64 == w ? UINT64_MAX : (1ULL << w) - 1;
+  uint64_t    v    = 0;
+  bool        neg  = false;
+
+  if (s < end && ('-' == *s || '+' == *s))
+    neg = '-' == *s++;
+  if (s == end)
+    return false;
+
+  if (DECODE_SIGNED == type->kind)
+    max = (max >> 1) + (neg ? 1 : 0);
+  else if (neg)
+    return false;
+
+  for (; s < end; ++s)
+  {
+    if (*s < '0' || *s > '9' || v > (max - (uint64_t)(*s - '0')) / 10)
+      return false;
+    v = v * 10 + (uint64_t)(*s - '0');
+  }
+
+  *bits = (neg ? 0 - v : v) & (64 == w ? UINT64_MAX : (1ULL << w) - 1);
+
+  return true;
+}
+
+// writes v in decimal, with a sign when plus is set
+char *decstr(char *out, int64_t v, const bool plus)
+{
+  char     tmp[20];
+  char    *t = tmp + sizeof(tmp);
+  uint64_t u = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+
+  do
+    *--t = (char)('0' + u % 10);
+  while (u /= 10);
+
+  if (v < 0)
+    *out++ = '-';
+  else if (plus)
+    *out++ = '+';
+  memcpy(out, t, (size_t)(tmp + sizeof(tmp) - t));
+
+  return out + (tmp + sizeof(tmp) - t);
+}
+
+// writes the low n nibbles of v in hex
+char *nibblestr(char *out, const uint64_t v, int n)
+{
+  static const char DIGIT[] = "0123456789abcdef";
+
+  for (; n > 0; --n)
+    *out++ = DIGIT[(v >> (4 * (n - 1))) & 15];
+
+  return out;
+}
+
+// writes the bits of a double in the form printf's %a uses
+char *hexfloat(char *out, const uint64_t bits)
+{
+  int      exp   = (int)((bits >> 52) & 0x7ff);
+  uint64_t mant  = bits & ((1ULL << 52) - 1);
+  int      n     = 13;
+
+  if (bits >> 63)
+    *out++ = '-';
+  if (0x7ff == exp)
+  {
+    memcpy(out, mant ? "nan" : "inf", 3);
+    return out + 3;
+  }
+
+  memcpy(out, exp ? "0x1" : "0x0", 3);
+  out += 3;
+  if (mant)
+  {
+    for (; 0 == (mant & 15); --n)
+      mant >>= 4;
+    *out++ = '.';
+    out    = nibblestr(out, mant, n);
+  }
+  *out++ = 'p';
+
+  return decstr(out, exp ? exp - 1023 : (mant ? -1022 : 0), true);
+}
+
+// renders the fields of one value after its token:
+//   floats:   sign exponent mantissa, %a, bit pattern, class
+//   integers: hex, bit pattern, whether a double holds it exactly
+char *decodeline(char *out, const struct decodetype *type, const uint64_t bits, const bool rounded)
+{
+  int      m    = type->mantbits;
+  int      e    = type->expbits;
+  uint64_t mant = bits & ((1ULL << m) - 1);
+  uint64_t exp  = (bits >> m) & ((1ULL << e) - 1);
+  uint64_t sign = bits >> (m + e);
+  int64_t  bias = (1LL << (e - 1)) - 1;
+  uint64_t top  = 0;
+  double   d    = 0.0;
+  float    f    = 0.0f;
+  char    *cls  = NULL;
+
+  if (DECODE_FLOAT != type->kind)
+  {
+    // integers of up to 53 significant bits convert to double exactly
+    top = DECODE_SIGNED == type->kind && (bits >> (8 * type->size - 1)) & 1
+        ? (0 - bits) & (8 == type->size ? UINT64_MAX : (1ULL << 8 * type->size) - 1)
+        : bits;
+    for (; top > (1ULL << 53) && 0 == (top & 1); top >>= 1)
+      ;
+    *out++ = '0';
+    *out++ = 'x';
+    out    = nibblestr(out, bits, 2 * (int)type->size);
+    *out++ = '\t';
+    bitstr(out, &bits, 8 * type->size);
+    out   += 8 * type->size;
+    cls    = top > (1ULL << 53) ? "\tinexact-double\n" : "\texact\n";
+    memcpy(out, cls, strlen(cls));
+    return out + strlen(cls);
+  }
+
+  *out++ = (char)('0' + sign);
+  *out++ = ' ';
+  out    = decstr(out, 0 == exp ? 1 - bias : (int64_t)exp - bias, true);
+  *out++ = ' ';
+  *out++ = '0';
+  *out++ = 'x';
+  out    = nibblestr(out, mant, (m + 3) / 4);
+  *out++ = '\t';
+
+  if (sizeof(float) == type->size)
+  {
+    uint32_t u = (uint32_t)bits;
+    uint64_t w = 0;
+    memcpy(&f, &u, sizeof(f));
+    d = f;
+    memcpy(&w, &d, sizeof(w));
+    out = hexfloat(out, w);
+  }
+  else
+  {
+    out = hexfloat(out, bits);
+  }
+  *out++ = '\t';
+
+  bitstr(out, &sign, 1);
+  out[1] = ' ';
+  bitstr(out + 2, &exp, (size_t)e);
+  out[2 + e] = ' ';
+  bitstr(out + 3 + e, &mant, (size_t)m);
+  out += 3 + e + m;
+
+  if (0 == exp)
+    cls = mant ? "\tsubnormal" : "\tzero";
+  else if ((uint64_t)(2 * bias + 1) == exp)
+    cls = 0 == mant ? "\tinf" : (mant >> (m - 1)) ? "\tnan" : "\tsnan";
+  else
+    cls = "\tnormal";
+  memcpy(out, cls, strlen(cls));
+  out += strlen(cls);
+
+  if (rounded)
+  {
+    memcpy(out, " rounded", 8);
+    out += 8;
+  }
+  *out++ = '\n';
+
+  return out;
+}
+
+// decodes one line of text: the trimmed token, then its fields
+bool decodetoken(struct decode *dec, const char *s, const char *end)
+{
+  const struct decodetype *type    = dec->type;
+  size_t                   len     = 0;
+  uint64_t                 bits    = 0;
+  bool                     ok      = false;
+  bool                     rounded = false;
+  double                   d       = 0.0;
+  float                    f       = 0.0f;
+  char                    *out     = NULL;
+
+  for (; s < end && (' ' == *s || '\t' == *s || '\r' == *s); ++s)
+    ;
+  for (; end > s && (' ' == end[-1] || '\t' == end[-1] || '\r' == end[-1]); --end)
+    ;
+  if (s == end)
+    return true;
+
+  // overlong lines are echoed truncated and rejected
+  len = (size_t)(end - s);
+  if (len > DECODE_TOKEN_MAX)
+  {
+    len = DECODE_TOKEN_MAX;
+  }
+  else
+  {
+    if (DECODE_FLOAT != type->kind)
+    {
+      ok = parseint(type, s, len, &bits);
+    }
+    else if (sizeof(double) == type->size)
+    {
+      ok = parsedouble(dec, s, len, &d);
+      memcpy(&bits, &d, sizeof(d));
+    }
+    else if ((ok = parsefloat(dec, s, len, &f)))
+    {
+      uint32_t u = 0;
+      memcpy(&u, &f, sizeof(u));
+      bits = u;
+      // the same text as a double tells whether float storage lost digits
+      rounded = parsedouble(dec, s, len, &d) && d == d && (double)f != d;
+    }
+  }
+
+  if (!sinkroom(&dec->out, len + 1 + DECODE_LINE_MAX))
+    return false;
+  out = dec->out.buf + dec->out.len;
+  memcpy(out, s, len);
+  out   += len;
+  *out++ = '\t';
+  if (ok)
+  {
+    out = decodeline(out, type, bits, rounded);
+  }
+  else
+  {
+    memcpy(out, "invalid\n", 8);
+    out += 8;
+  }
+  dec->out.len = (size_t)(out - dec->out.buf);
+
+  return true;
+}
+
+// decodes a block of text, one number per line, carrying a line that is
+// split across blocks over to the next one
+bool decodetext(void *ctx, const unsigned char *in, const size_t len)
+{
+  struct decode *dec  = ctx;
+  const char    *p    = (const char *)in;
+  const char    *end  = p + len;
+  const char    *nl   = NULL;
+  size_t         take = 0;
+
+  for (; p < end; p = nl + 1)
+  {
+    nl = memchr(p, '\n', (size_t)(end - p));
+
+    if (dec->carried > 0 || NULL == nl)
+    {
+      // one byte beyond DECODE_TOKEN_MAX is enough to reject the line
+      take = (size_t)((nl ? nl : end) - p);
+      if (take > sizeof(dec->carry) - dec->carried)
+        take = sizeof(dec->carry) - dec->carried;
+      memcpy(dec->carry + dec->carried, p, take);
+      dec->carried += take;
+      if (NULL == nl)
+        return true;
+      if (!decodetoken(dec, dec->carry, dec->carry + dec->carried))
+        return false;
+      dec->carried = 0;
+    }
+    else if (!decodetoken(dec, p, nl))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// decodes a block of raw records in native byte order. blocks only end
+// mid-record at the end of the input, where the remainder is reported.
+bool decoderaw(void *ctx, const unsigned char *in, const size_t len)
+{
+  struct decode *dec  = ctx;
+  size_t         size = dec->type->size;
+  size_t         i    = 0;
+  uint64_t       bits = 0;
+  uint8_t        u8   = 0;
+  uint16_t       u16  = 0;
+  uint32_t       u32  = 0;
+
+  for (i = 0; i + size <= len; i += size)
+  {
+    switch (size)
+    {
+      case 1:  memcpy(&u8, in + i, 1);  bits = u8;  break;
+      case 2:  memcpy(&u16, in + i, 2); bits = u16; break;
+      case 4:  memcpy(&u32, in + i, 4); bits = u32; break;
+      default: memcpy(&bits, in + i, 8);            break;
+    }
+    if (!sinkroom(&dec->out, DECODE_LINE_MAX))
+      return false;
+    dec->out.len = (size_t)(decodeline(dec->out.buf + dec->out.len, dec->type, bits, false) - dec->out.buf);
+  }
+  dec->trailing += len - i;
+
+  return true;
+}
+
+// decodes a file ("-" for standard input) of numbers of the named type,
+// given one per line or, with raw set, as binary records
+bool decodefile(const char *name, const char *path, const bool raw)
+{
+  struct decode dec;
+  bool          ok = false;
+  size_t        i  = 0;
+
+  memset(&dec, 0, sizeof(dec));
+  if (NULL == (dec.type = decodetype(name)))
+  {
+    fprintf(stderr, "ctypes: unknown --decode type '%s' (", name);
+    for (i = 0; i < sizeof(DECODETYPES) / sizeof(*DECODETYPES); ++i)
+      fprintf(stderr, "%s%s", i ? ", " : "", DECODETYPES[i].name);
+    fprintf(stderr, ")\n");
+    return false;
+  }
+
+  if ((locale_t)0 == (dec.clocale = newlocale(LC_ALL_MASK, "C", (locale_t)0)))
+  {
+    perror("newlocale");
+    return false;
+  }
+  bittables();
+  if (NULL == (dec.out.buf = malloc(DUMP_OUTBUF)))
+  {
+    perror("malloc");
+    freelocale(dec.clocale);
+    return false;
+  }
+
+  ok = readstream(path, raw ? decoderaw : decodetext, &dec);
+  if (ok && dec.carried > 0)
+    ok = decodetoken(&dec, dec.carry, dec.carry + dec.carried);
+  ok = ok && sinkflush(&dec.out);
+  if (dec.trailing > 0)
+    fprintf(stderr, "ctypes: ignored %zu trailing byte(s) short of a %zu-byte record\n", dec.trailing, dec.type->size);
+
+  free(dec.out.buf);
+  freelocale(dec.clocale);
+
+  return ok;
+}
+
+struct profileheader
+{
+  char     magic[4];             // "CTPC"
+  uint32_t version;              // PROFILE_VERSION
+  char     key[PROFILE_KEY_LEN]; // must match profilekey() of the reader
+  uint32_t values;               // struct profilevalue, sorted by name
+  uint32_t sections;             // struct profilesection, after the values
+  uint64_t size;                 // of the whole file
+};
+
+struct profilesection
+{
+  uint32_t id;
+  uint32_t length;
+  uint64_t offset;               // of the report text, from the file start
+};
+
+// 64-bit FNV-1a
+uint64_t fnv1a(uint64_t hash, const unsigned char *p, size_t n)
+{
+  for (; n > 0; --n)
+    hash = (hash ^ *p++) * 0x100000001b3ULL;
+
+  return hash;
+}
+
+// dl_iterate_phdr() callback: writes the GNU build-id note of the first
+// object, the executable, as hex to data. the notes are read from the loaded
+// program headers, so nothing is read from disk.
+int buildid(struct dl_phdr_info *info, size_t size, void *data)
+{
+  const ElfW(Nhdr) *note  = NULL;
+  const char       *p     = NULL;
+  const char       *end   = NULL;
+  char             *hex   = data;
+  size_t            align = 0;
+  uint32_t          n     = 0;
+  int               i     = 0;
+
+  (void)size;
+
+  for (i = 0; i < info->dlpi_phnum; ++i)
+  {
+    if (PT_NOTE != info->dlpi_phdr[i].p_type)
+      continue;
+    align = 8 == info->dlpi_phdr[i].p_align ? 8 : 4;
+    p     = (const char *)(info->dlpi_addr + info->dlpi_phdr[i].p_vaddr);
+    end   = p + info->dlpi_phdr[i].p_memsz;
+    while (p + sizeof(*note) <= end)
+    {
+      note = (const ElfW(Nhdr) *)p;
+      p   += sizeof(*note) + ((note->n_namesz + align - 1) & ~(align - 1));
+      if (NT_GNU_BUILD_ID == note->n_type && 4 == note->n_namesz && 0 == memcmp(note + 1, "GNU", 4))
+      {
+        for (n = 0; n < note->n_descsz && n < 32; ++n)
+          (void)sprintf(hex + 2 * n, "%02x", (unsigned char)p[n]);
+        return 1;
+      }
+      p += (note->n_descsz + align - 1) & ~(align - 1);
+    }
+  }
+
+  return 1;
+}
+
+// identifies the measuring conditions: the cpu model and microcode from the
+// first processor in /proc/cpuinfo, the kernel, and this binary by its
+// build-id, or by the device, inode, size and mtime of the file without one.
+// a cache written under any other key is ignored.
+void profilekey(char *key, const size_t len)
+{
+  struct utsname uts;
+  struct stat    st;
+  FILE          *cpuinfo = fopen("/proc/cpuinfo", "r");
+  char           line[256];
+  char           model[128] = "";
+  char           micro[64]  = "";
+  char           binary[72] = "";
+  char          *value      = NULL;
+
+  while (NULL != cpuinfo && NULL != fgets(line, sizeof(line), cpuinfo) && '\n' != line[0])
+  {
+    if (NULL == (value = strchr(line, ':')))
+      continue;
+    for (++value; ' ' == *value; ++value)
+      ;
+    value[strcspn(value, "\n")] = '\0';
+    if (0 == strncmp(line, "model name", 10) || ('\0' == model[0] && 0 == strncmp(line, "CPU part", 8)))
+      (void)snprintf(model, sizeof(model), "%s", value);
+    else if (0 == strncmp(line, "microcode", 9))
+      (void)snprintf(micro, sizeof(micro), "%s", value);
+  }
+  if (NULL != cpuinfo)
+    fclose(cpuinfo);
+
+  (void)dl_iterate_phdr(buildid, binary);
+  if ('\0' == binary[0] && 0 == stat("/proc/self/exe", &st))
+    (void)snprintf(binary, sizeof(binary), "%jx:%jx:%jd:%jd", (uintmax_t)st.st_dev, (uintmax_t)st.st_ino,
+      (intmax_t)st.st_size, (intmax_t)st.st_mtime);
+
+  if (0 != uname(&uts))
+    memset(&uts, 0, sizeof(uts));
+
+  (void)snprintf(key, len, "cpu=%s;microcode=%s;kernel=%s %s %s;binary=%s",
+    model, micro, uts.release, uts.version, uts.machine, binary);
+}
+
+// maps the cache file at $XDG_CACHE_HOME/ctypes/profile-<hash>.bin (or
+// under ~/.cache), keeping it only if it is complete and was written under
+// the current key. the hash in the name is of the key, so binaries built
+// differently, or hosts sharing a home directory, each keep their own file
+// instead of replacing each other's. only runs that measure or query call
+// this.
+void profileload()
+{
+  const struct profileheader  *head = NULL;
+  const struct profilesection *sect = NULL;
+  const char                  *base = getenv("XDG_CACHE_HOME");
+  const char                  *home = getenv("HOME");
+  struct stat                  st;
+  size_t                       i    = 0;
+  size_t                       end  = 0;
+  size_t                       len  = 0;
+  void                        *map  = MAP_FAILED;
+  int                          fd   = -1;
+
+  if (NULL != base && '/' == base[0])
+    (void)snprintf(PROFILE.path, sizeof(PROFILE.path), "%s/ctypes", base);
+  else if (NULL != home && '\0' != home[0])
+    (void)snprintf(PROFILE.path, sizeof(PROFILE.path), "%s/.cache/ctypes", home);
+  else
+    return;
+
+  profilekey(PROFILE.key, sizeof(PROFILE.key));
+
+  len = strlen(PROFILE.path);
+  (void)snprintf(PROFILE.path + len, sizeof(PROFILE.path) - len, "/profile-%016" PRIx64 ".bin",
+    fnv1a(0xcbf29ce484222325ULL, (const unsigned char *)PROFILE.key, strlen(PROFILE.key)));
+
+  if ((fd = open(PROFILE.path, O_RDONLY)) < 0)
+    return;
+  if (0 == fstat(fd, &st) && (size_t)st.st_size >= sizeof(*head))
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (MAP_FAILED == map)
+    return;
+
+  head = map;
+  end  = sizeof(*head) + head->values * sizeof(struct profilevalue) + head->sections * sizeof(*sect);
+  if (0 != memcmp(head->magic, "CTPC", 4) || PROFILE_VERSION != head->version ||
+      (uint64_t)st.st_size != head->size || end > head->size ||
+      0 != strncmp(head->key, PROFILE.key, sizeof(head->key)))
+  {
+    (void)munmap(map, (size_t)st.st_size);
+    return;
+  }
+
+  sect = (const struct profilesection *)((const struct profilevalue *)(head + 1) + head->values);
+  for (i = 0; i < head->sections; ++i)
+  {
+    if (sect[i].id >= SECTION_COUNT || sect[i].offset > head->size || sect[i].length > head->size - sect[i].offset)
+    {
+      (void)munmap(map, (size_t)st.st_size);
+      return;
+    }
+  }
+
+  PROFILE.map     = map;
+  PROFILE.mapsize = (size_t)st.st_size;
+}
+
+int profilecompare(const void *a, const void *b)
+{
+  return strcmp(((const struct profilevalue *)a)->name, ((const struct profilevalue *)b)->name);
+}
+
+// looks up a value in the cache file
+const struct profilevalue *profilevalue(const char *name)
+{
+  const struct profileheader *head = (const struct profileheader *)PROFILE.map;
+  struct profilevalue         key;
+
+  if (NULL == head)
+    return NULL;
+
+  (void)snprintf(key.name, sizeof(key.name), "%s", name);
+
+  return bsearch(&key, head + 1, head->values, sizeof(key), profilecompare);
+}
+
+// looks up the report text of a section in the cache file
+const char *profiletext(const int section, size_t *len)
+{
+  const struct profileheader  *head = (const struct profileheader *)PROFILE.map;
+  const struct profilesection *sect = NULL;
+  uint32_t                     i    = 0;
+
+  if (NULL == head)
+    return NULL;
+
+  sect = (const struct profilesection *)((const struct profilevalue *)(head + 1) + head->values);
+  for (i = 0; i < head->sections; ++i)
+  {
+    if ((uint32_t)section == sect[i].id)
+    {
+      *len = sect[i].length;
+      return (const char *)PROFILE.map + sect[i].offset;
+    }
+  }
+
+  return NULL;
+}
+
+// creates the directory of the cache file and its parent, in case
+// ~/.cache does not exist yet
+void profiledir()
+{
+  char  dir[PATH_MAX];
+  char *slash = NULL;
+
+  (void)snprintf(dir, sizeof(dir), "%s", PROFILE.path);
+  if (NULL == (slash = strrchr(dir, '/')))
+    return;
+  *slash = '\0';
+  if (NULL != (slash = strrchr(dir, '/')))
+  {
+    *slash = '\0';
+    (void)mkdir(dir, 0700);
+    *slash = '/';
+  }
+  (void)mkdir(dir, 0700);
+}
+
+// merges what this run measured with the sections it did not measure from
+// the existing cache, and replaces the file atomically
+void profilesave()
+{
+  const struct profileheader  *old     = (const struct profileheader *)PROFILE.map;
+  const struct profilevalue   *oldval  = NULL;
+  const char                  *text    = NULL;
+  struct profileheader        *head    = NULL;
+  struct profilevalue         *val     = NULL;
+  struct profilesection       *sect    = NULL;
+  char                        *buf     = NULL;
+  char                         tmp[PATH_MAX + 16];
+  size_t                       values  = PROFILE.values;
+  size_t                       size    = 0;
+  size_t                       len     = 0;
+  size_t                       off     = 0;
+  size_t                       i       = 0;
+  uint32_t                     n       = 0;
+  int                          section = 0;
+  int                          fd      = -1;
+
+  for (section = 0; section < SECTION_COUNT && !PROFILE.measured[section]; ++section)
+    ;
+  if (SECTION_COUNT == section || '\0' == PROFILE.path[0])
+    return;
+
+  // sized for everything old and new; sections that were measured again
+  // simply leave some of it unused
+  size = sizeof(*head) + SECTION_COUNT * sizeof(*sect);
+  if (NULL != old)
+    size += old->size;
+  size += values * sizeof(*val);
+  for (section = 0; section < SECTION_COUNT; ++section)
+    size += PROFILE.textlen[section];
+  if (NULL == (buf = calloc(1, size)))
+    return;
+
+  head = (struct profileheader *)buf;
+  val  = (struct profilevalue *)(head + 1);
+  memcpy(val, PROFILE.value, values * sizeof(*val));
+  if (NULL != old)
+  {
+    oldval = (const struct profilevalue *)(old + 1);
+    for (i = 0; i < old->values; ++i)
+      if (oldval[i].section < SECTION_COUNT && !PROFILE.measured[oldval[i].section])
+        val[values++] = oldval[i];
+  }
+  qsort(val, values, sizeof(*val), profilecompare);
+
+  sect = (struct profilesection *)(val + values);
+  off  = sizeof(*head) + values * sizeof(*val) + SECTION_COUNT * sizeof(*sect);
+  for (section = 0; section < SECTION_COUNT; ++section)
+  {
+    if (PROFILE.measured[section])
+    {
+      text = PROFILE.text[section];
+      len  = PROFILE.textlen[section];
+    }
+    else if (NULL == (text = profiletext(section, &len)))
+    {
+      continue;
+    }
+    sect[n].id     = (uint32_t)section;
+    sect[n].length = (uint32_t)len;
+    sect[n].offset = off;
+    memcpy(buf + off, text, len);
+    off += len;
+    ++n;
+  }
+
+  memcpy(head->magic, "CTPC", 4);
+  head->version  = PROFILE_VERSION;
+  memcpy(head->key, PROFILE.key, sizeof(head->key));
+  head->values   = (uint32_t)values;
+  head->sections = n;
+  head->size     = off;
+
+  profiledir();
+  (void)snprintf(tmp, sizeof(tmp), "%s.%ld", PROFILE.path, (long)getpid());
+  if ((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600)) < 0 ||
+      !writeall(fd, buf, off) || 0 != close(fd) || 0 != rename(tmp, PROFILE.path))
+  {
+    fprintf(stderr, "ctypes: cannot write profile cache %s: %s\n", PROFILE.path, strerror(errno));
+    (void)unlink(tmp);
+  }
+
+  free(buf);
+}
+
+// stdout while a section is measured: keeps a copy of its text for the
+// cache and passes it on unless the run only answers a --query
+ssize_t capturewrite(void *cookie, const char *buf, size_t len)
+{
+  int    section = *(int *)cookie;
+  size_t have    = PROFILE.textlen[section];
+  char  *text    = realloc(PROFILE.text[section], have + len);
+
+  if (NULL == text)
+    return -1;
+  memcpy(text + have, buf, len);
+  PROFILE.text[section]     = text;
+  PROFILE.textlen[section] += len;
+
+  if (PROFILE.echo)
+  {
+    (void)fwrite(buf, 1, len, PROFILE.out);
+    // sections flush to show progress; keep that on a terminal
+    if (PROFILE.tty)
+      (void)fflush(PROFILE.out);
+  }
+
+  return (ssize_t)len;
+}
+
+// prints a section from the cache, or measures it while capturing its
+// report and published values for the cache
+void runsection(const int section, void (*print)(void), const bool refresh, const bool echo)
+{
+  static const cookie_io_functions_t CAPTURE = { NULL, capturewrite, NULL, NULL };
+
+  const char *text = NULL;
+  size_t      len  = 0;
+  FILE       *tee  = NULL;
+
+  if (PROFILE.measured[section])
+  {
+    if (echo)
+      (void)fwrite(PROFILE.text[section], 1, PROFILE.textlen[section], stdout);
+    return;
+  }
+
+  if (!refresh && NULL != (text = profiletext(section, &len)))
+  {
+    if (echo)
+      (void)fwrite(text, 1, len, stdout);
+    return;
+  }
+
+  (void)fflush(stdout);
+  PROFILE.section = section;
+  memset(&QUALITY, 0, sizeof(QUALITY));
+  if (NULL == (tee = fopencookie(&PROFILE.section, "w", CAPTURE)))
+  {
+    print();
+    return;
+  }
+
+  free(PROFILE.text[section]);
+  PROFILE.text[section]    = NULL;
+  PROFILE.textlen[section] = 0;
+  PROFILE.out              = stdout;
+  PROFILE.echo             = echo;
+  PROFILE.tty              = isatty(STDOUT_FILENO);
+
+  stdout = tee;
+  print();
+  (void)fclose(tee);
+  stdout = PROFILE.out;
+
+  PROFILE.measured[section] = true;
+}
+
+static const struct
+{
+  const char *pattern; // '*' matches any run of characters
+  int         section;
+}
+PROFILEKEYS[] = {
+  { "cpu_ghz",             SECTION_BENCH    },
+  { "cache_line",          SECTION_MEMORY   },
+  { "L*_size",             SECTION_MEMORY   },
+  { "L*_ns",               SECTION_MEMORY   },
+  { "memory_ns",           SECTION_MEMORY   },
+  { "*_gbps",              SECTION_COPY     },
+  { "atomic_*",            SECTION_ATOMICS  },
+  { "c2c_*",               SECTION_ATOMICS  },
+  { "false_sharing_x",     SECTION_ATOMICS  },
+  { "peak_gflops",         SECTION_SIMD     },
+  { "subnormal_penalty_x", SECTION_DENORMAL },
+  { "page_size",           SECTION_VM       },
+  { "hugepage_size",       SECTION_VM       },
+  { "*_ns_per_4k",         SECTION_VM       },
+};
+
+bool keymatch(const char *pattern, const char *key)
+{
+  if ('*' == *pattern)
+    return keymatch(pattern + 1, key) || ('\0' != *key && keymatch(pattern, key + 1));
+  if ('\0' == *pattern)
+    return '\0' == *key;
+
+  return *pattern == *key && keymatch(pattern + 1, key + 1);
+}
+
+static void (*const SECTIONPRINT[SECTION_COUNT])(void) = {
+  printcosts, printmemory, printcopy, printatomics, printsimd, printdenormal, printvm,
+};
+
+// --only/--skip also accept the two unmeasured reports
+#define SELECT_MEASURED ((1U << SECTION_COUNT) - 1)
+#define SELECT_SIZES    (1U << SECTION_COUNT)
+#define SELECT_CONSTS   (1U << (SECTION_COUNT + 1))
+#define SELECT_ALL      (SELECT_MEASURED | SELECT_SIZES | SELECT_CONSTS)
+
+// per-core compute probes, measured side by side on separate cores. the
+// rest measure shared resources (caches, memory bandwidth, page faults,
+// core-to-core lines) and always run alone.
+#define SECTION_PARALLEL (1U << SECTION_BENCH | 1U << SECTION_SIMD | 1U << SECTION_DENORMAL)
+
+// parses a comma-separated list of section names into a SELECT mask
+bool parsesections(const char *list, unsigned *mask)
+{
+  const char *end = NULL;
+  size_t      len = 0;
+  int         s   = 0;
+
+  for (*mask = 0; '\0' != *list; list = '\0' == *end ? end : end + 1)
+  {
+    end = list + strcspn(list, ",");
+    len = (size_t)(end - list);
+    if (5 == len && 0 == strncmp(list, "sizes", len))
+    {
+      *mask |= SELECT_SIZES;
+      continue;
+    }
+    if (6 == len && 0 == strncmp(list, "consts", len))
+    {
+      *mask |= SELECT_CONSTS;
+      continue;
+    }
+    for (s = 0; s < SECTION_COUNT; ++s)
+      if (len == strlen(SECTIONNAME[s]) && 0 == strncmp(list, SECTIONNAME[s], len))
+        break;
+    if (SECTION_COUNT == s)
+    {
+      fprintf(stderr, "ctypes: unknown section '%.*s' (sizes, consts", (int)len, list);
+      for (s = 0; s < SECTION_COUNT; ++s)
+        fprintf(stderr, ", %s", SECTIONNAME[s]);
+      fprintf(stderr, ")\n");
+      return false;
+    }
+    *mask |= 1U << s;
+  }
+
+  return true;
+}
+
+// lists the allowed CPUs, keeping only the first hardware thread of each
+// core so that parallel probes do not share execution units
+int corelist(int *cores, const int max)
+{
+  int  cpus[CPU_SETSIZE];
+  int  ncpu = cpulist(cpus, CPU_SETSIZE);
+  int  n    = 0;
+  int  i    = 0;
+  char path[128];
+  char line[64];
+
+  for (i = 0; i < ncpu && n < max; ++i)
+  {
+    (void)snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpus[i]);
+    if (!readline(path, line, sizeof(line)) || atoi(line) == cpus[i])
+      cores[n++] = cpus[i];
+  }
+
+  return n;
+}
+
+// moves the whole process onto one CPU, saving the previous mask if asked
+bool pinprocess(const int cpu, cpu_set_t *saved)
+{
+  cpu_set_t set;
+
+  if (NULL != saved && 0 != sched_getaffinity(0, sizeof(*saved), saved))
+    return false;
+
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  return 0 == sched_setaffinity(0, sizeof(set), &set);
+}
+
+// results a child process hands back to the scheduler
+struct childprofile
+{
+  size_t              values;
+  struct profilevalue value[PROFILE_MAX];
+};
+
+// measures the sections in mask at the same time, each in a child process
+// pinned to its own core, in waves of as many sections as there are cores.
+// their report text and published values are collected as if they had been
+// measured here, so runsection() then only prints them in order.
+void runparallel(const unsigned mask)
+{
+  struct childprofile *shared = NULL;
+  FILE                *out[SECTION_COUNT];
+  pid_t                pid[SECTION_COUNT];
+  int                  cores[CPU_SETSIZE];
+  int                  ncore  = corelist(cores, CPU_SETSIZE);
+  int                  wave[SECTION_COUNT];
+  int                  waves  = 0;
+  int                  status = 0;
+  int                  s      = 0;
+  int                  w      = 0;
+  long                 len    = 0;
+  size_t               i      = 0;
+  size_t               j      = 0;
+
+  for (s = 0; s < SECTION_COUNT; ++s)
+    if (mask & 1U << s)
+      wave[waves++] = s;
+  if (waves < 2 || ncore < 2)
+    return;
+
+  shared = mmap(NULL, SECTION_COUNT * sizeof(*shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (MAP_FAILED == shared)
+    return;
+  (void)fflush(stdout);
+
+  for (w = 0; w < waves; w += ncore)
+  {
+    for (i = 0; i < (size_t)ncore && w + (int)i < waves; ++i)
+    {
+      s      = wave[w + i];
+      pid[s] = -1;
+      if (NULL == (out[s] = tmpfile()) || (pid[s] = fork()) < 0)
+        continue;
+      if (0 == pid[s])
+      {
+        (void)pinprocess(cores[i], NULL);
+        (void)dup2(fileno(out[s]), STDOUT_FILENO);
+        PROFILE.values  = 0;
+        PROFILE.section = s;
+        memset(&QUALITY, 0, sizeof(QUALITY));
+        SECTIONPRINT[s]();
+        (void)fflush(stdout);
+        shared[s].values = PROFILE.values;
+        memcpy(shared[s].value, PROFILE.value, PROFILE.values * sizeof(*PROFILE.value));
+        _exit(0);
+      }
+    }
+
+    for (i = 0; i < (size_t)ncore && w + (int)i < waves; ++i)
+    {
+      s = wave[w + i];
+      if (pid[s] > 0 && pid[s] == waitpid(pid[s], &status, 0) && WIFEXITED(status) && 0 == WEXITSTATUS(status) &&
+          (len = ftell(out[s])) >= 0 && NULL != (PROFILE.text[s] = malloc((size_t)len + 1)))
+      {
+        rewind(out[s]);
+        PROFILE.textlen[s] = fread(PROFILE.text[s], 1, (size_t)len, out[s]);
+        PROFILE.section    = s;
+        for (j = 0; j < shared[s].values; ++j)
+          publish(shared[s].value[j].value, "%s", shared[s].value[j].name);
+        PROFILE.measured[s] = true;
+      }
+      if (NULL != out[s])
+        fclose(out[s]);
+    }
+  }
+
+  (void)munmap(shared, SECTION_COUNT * sizeof(*shared));
+}
+
+// prints the selected sections in their usual order. per-core compute
+// sections that need measuring run in parallel first; everything else is
+// measured one at a time, pinned to the first core except for the atomics
+// probes, which place their own threads.
+void runsections(const unsigned mask, const bool refresh)
+{
+  unsigned  parallel = 0;
+  cpu_set_t saved;
+  size_t    len      = 0;
+  int       cores[1];
+  int       s        = 0;
+  bool      pinned   = false;
+
+  for (s = 0; s < SECTION_COUNT; ++s)
+    if ((mask & SECTION_PARALLEL & 1U << s) && (refresh || NULL == profiletext(s, &len)))
+      parallel |= 1U << s;
+  runparallel(parallel);
+
+  for (s = 0; s < SECTION_COUNT; ++s)
+  {
+    if (!(mask & 1U << s))
+      continue;
+    pinned = SECTION_ATOMICS != s && !PROFILE.measured[s] && 1 == corelist(cores, 1) && pinprocess(cores[0], &saved);
+    runsection(s, SECTIONPRINT[s], refresh, true);
+    if (pinned)
+      (void)sched_setaffinity(0, sizeof(saved), &saved);
+  }
+}
+
+// answers the published values that are read from the system rather than
+// measured: 1 with the value, 0 if the host has none, -1 for other names
+int directvalue(const char *name, double *value)
+{
+  if (0 == strcmp(name, "page_size"))
+    *value = (double)sysconf(_SC_PAGESIZE);
+  else if (0 == strcmp(name, "cache_line"))
+    *value = (double)cachelinesize();
+  else if (0 == strcmp(name, "hugepage_size"))
+    return 0 != (*value = (double)hugepagesize()) ? 1 : 0;
+  else
+    return -1;
+
+  return 1;
+}
+
+// answers a single value: a type-related constant from the registry, a value
+// read from the system, or a measured value from the cache. a miss measures
+// the value's section, unless the cache already holds that section, in which
+// case the host simply does not have the value (an absent L4, say).
+bool profilequery(const char *name, const bool refresh)
+{
+  const struct profilevalue *cached  = NULL;
+  double                     value   = 0.0;
+  int                        section = -1;
+  int                        direct  = 0;
+  size_t                     len     = 0;
+  size_t                     i       = 0;
+
+  for (i = 0; i < CCONST_COUNT; ++i)
+  {
+    if (0 == strcmp(CCONSTS[i].name, name))
+    {
+      printconstvalue(&CCONSTS[i], NULL, "");
+      putchar('\n');
+      return true;
+    }
+  }
+
+  for (i = 0; i < sizeof(PROFILEKEYS) / sizeof(*PROFILEKEYS) && section < 0; ++i)
+    if (keymatch(PROFILEKEYS[i].pattern, name))
+      section = PROFILEKEYS[i].section;
+  if (section < 0)
+  {
+    fprintf(stderr, "ctypes: unknown query '%s'\n", name);
+    return false;
+  }
+
+  if ((direct = directvalue(name, &value)) >= 0)
+  {
+    if (0 == direct)
+    {
+      fprintf(stderr, "ctypes: '%s' is not available on this host\n", name);
+      return false;
+    }
+    printf("%.15g\n", value);
+    return true;
+  }
+
+  profileload();
+
+  if (!refresh)
+    cached = profilevalue(name);
+  if (NULL == cached && (refresh || NULL == profiletext(section, &len)))
+  {
+    runsection(section, SECTIONPRINT[section], true, false);
+    profilesave();
+    for (i = 0; i < PROFILE.values; ++i)
+      if (0 == strcmp(PROFILE.value[i].name, name))
+        cached = &PROFILE.value[i];
+  }
+  if (NULL == cached)
+  {
+    fprintf(stderr, "ctypes: '%s' is not measured on this host (see --%s)\n", name, SECTIONNAME[section]);
+    return false;
+  }
+
+  printf("%.15g\n", cached->value);
+
+  return true;
+}
+
+static const struct option LONGOPTS[] = {
+  { "bench",    no_argument,       NULL,  'b' },
+  { "memory",   no_argument,       NULL,  'm' },
+  { "copy",     no_argument,       NULL,  'y' },
+  { "atomics",  no_argument,       NULL,  'a' },
+  { "simd",     no_argument,       NULL,  's' },
+  { "denormal", no_argument,       NULL,  'd' },
+  { "vm",       no_argument,       NULL,  'v' },
+  { "bits",     required_argument, NULL,  'B' },
+  { "decode",   required_argument, NULL,  'D' },
+  { "raw",      no_argument,       NULL,  'r' },
+  { "format",   required_argument, NULL,  'f' },
+  { "query",    required_argument, NULL,  'q' },
+  { "refresh",  no_argument,       NULL,  'R' },
+  { "only",     required_argument, NULL,  'O' },
+  { "skip",     required_argument, NULL,  'S' },
+  { "layout",   required_argument, NULL,  'l' },
+  { "count",    required_argument, NULL,  'n' },
+  { NULL,       0,                 NULL,    0 },
+};
+
+int main(int argc, char *argv[])
+{
+  unsigned select   = 0;
+  unsigned only     = 0;
+  unsigned skip     = 0;
+  bool   consts     = false;
+  char  *spec       = NULL;
+  char  *bits       = NULL;
+  char  *decode     = NULL;
+  bool   raw        = false;
+  int    format     = FORMAT_TEXT;
+  char  *query      = NULL;
+  char  *end        = NULL;
+  bool   refresh    = false;
+  size_t count      = LAYOUT_COUNT;
+  int    c          = 0;
+
+  opterr = 0;
+
+  while (-1 != (c = getopt_long(argc, argv, "bmyasdvB:D:rf:q:RO:S:l:n:", LONGOPTS, NULL)))
+  {
+    switch (c)
+    {
+      case 'b':
+        select |= 1U << SECTION_BENCH;
+        break;
+
+      case 'm':
+        select |= 1U << SECTION_MEMORY;
+        break;
+
+      case 'y':
+        select |= 1U << SECTION_COPY;
+        break;
+
+      case 'a':
+        select |= 1U << SECTION_ATOMICS;
+        break;
+
+      case 's':
+        select |= 1U << SECTION_SIMD;
+        break;
+
+      case 'd':
+        select |= 1U << SECTION_DENORMAL;
+        break;
+
+      case 'v':
+        select |= 1U << SECTION_VM;
+        break;
+
+      case 'B':
+        bits = optarg;
+        break;
+
+      case 'D':
+        decode = optarg;
+        break;
+
+      case 'r':
+        raw = true;
+        break;
+
+      case 'f':
+        for (format = FORMAT_BINARY; format > FORMAT_TEXT; --format)
+        {
+          if (0 == strcmp(optarg, FORMATNAME[format]))
+            break;
+        }
+        if (FORMAT_TEXT == format && 0 != strcmp(optarg, FORMATNAME[format]))
+        {
+          fprintf(stderr, "ctypes: unknown --format '%s' (text, json, csv, binary)\n", optarg);
+          return 1;
+        }
+        break;
+
+      case 'q':
+        query = optarg;
+        break;
+
+      case 'R':
+        refresh = true;
+        break;
+
+      case 'O':
+        if (!parsesections(optarg, &only))
+          return 1;
+        break;
+
+      case 'S':
+        if (!parsesections(optarg, &skip))
+          return 1;
+        break;
+
+      case 'l':
+        spec = optarg;
+        break;
+
+      case 'n':
+        errno = 0;
+        count = strtoull(optarg, &end, 0);
+        if (end == optarg || '\0' != *end || 0 != errno || '-' == optarg[strspn(optarg, " \t")] || 0 == count)
+        {
+          fprintf(stderr, "ctypes: invalid --count '%s' (a positive array length)\n", optarg);
+          return 2;
+        }
+        break;
+
+      default:
+        // any unrecognized argument still selects the constants report
+        consts = true;
+        break;
+    }
+  }
+
+  // filters write only their own output
+  if (NULL != bits)
+  {
+    return dumpbits(bits) ? 0 : 1;
+  }
+
+  if (NULL != decode)
+  {
+    return decodefile(decode, optind < argc ? argv[optind] : "-", raw) ? 0 : 1;
+  }
+
+  if (optind < argc)
+  {
+    consts = true;
+  }
+
+  // reports go out through one static buffer, so a piped report costs a
+  // single write() per flush instead of one per stdio block
+  if (!isatty(STDOUT_FILENO))
+  {
+    (void)setvbuf(stdout, OUTBUF, _IOFBF, sizeof(OUTBUF));
+  }
+
+  if (NULL != query)
+  {
+    return profilequery(query, refresh) ? 0 : 1;
+  }
+
+  if (FORMAT_TEXT != format)
+  {
+    if (0 != (select & ~(SELECT_SIZES | SELECT_CONSTS)) || 0 != only || NULL != spec)
+    {
+      fprintf(stderr, "ctypes: --format %s covers the type and constant registry only\n", FORMATNAME[format]);
+      return 1;
+    }
+    printregistry(format);
+    return 0;
+  }
+
+  // the report options add to the size table; --only replaces the whole
+  // selection, and --skip alone means everything else
+  select |= SELECT_SIZES | (consts ? SELECT_CONSTS : 0);
+  if (0 != only)
+    select = only;
+  else if (0 != skip && (SELECT_SIZES | (consts ? SELECT_CONSTS : 0)) == select && NULL == spec)
+    select = SELECT_ALL;
+  select &= ~skip;
+
+  // the cache is only opened when a measured section may be replayed
+  if (select & SELECT_MEASURED)
+  {
+    profileload();
+  }
+
+  if (select & SELECT_SIZES)
+  {
+    printsizes();
+  }
+
+  if (select & SELECT_CONSTS)
+  {
+    printconsts();
+  }
+
+  if (select & SELECT_MEASURED)
+  {
+    runsections(select, refresh);
+    profilesave();
+  }
 
-  if (argc > 1)
+  if (NULL != spec)
   {
-    if (true)
+    if (!printlayout(spec, count))
     {
-      printconsts();
+      return 1;
     }
   }
 
@@ -0,0 +1,56 @@
+#!/bin/bash
+#
+# compares calls per second of the errcho bash builtin, the standalone
+# errcho binary and bash's own 'echo >&2', writing to /dev/null
+#
+# usage: errcho-bench.sh [calls] [errcho binary] [errcho.so builtin]
+#
+
+calls=${1:-10000}
+binary=${2:-./errcho}
+builtin=${3:-./errcho.so}
+
+line="the quick brown fox jumps over the lazy dog"
+
+# prints calls/sec and µs/call of the given command run $calls times
+function bench
+{
+  local name=$1
+  shift
+
+  local start=${EPOCHREALTIME/[.,]/}
+  local i
+  for (( i = 0; i < calls; ++i ))
+  do
+    "$@" ${line} 2> /dev/null
+  done
+  local usec=$(( ${EPOCHREALTIME/[.,]/} - start ))
+  (( usec > 0 )) || usec=1
+
+  printf "%-12s %10d calls/sec %7d.%02d us/call\n" "${name}" \
+    $(( calls * 1000000 / usec )) $(( usec / calls )) $(( usec * 100 / calls % 100 ))
+}
+
+function echoerr
+{
+  echo "$@" >&2
+}
+
+if [[ ! -x "${binary}" ]]
+then
+  echo "error: errcho binary not found: ${binary}" >&2
+  exit 1
+fi
+
+printf "%d calls each\n" ${calls}
+
+bench "echo >&2" echoerr
+bench "binary" "${binary}"
+
+if enable -f "${builtin}" errcho 2> /dev/null
+then
+  bench "builtin" errcho
+  enable -d errcho
+else
+  echo "builtin      not loaded: ${builtin}"
+fi
@@ -1,33 +1,1157 @@
 // echo utility that prints to stderr instead of stdout
 //   -n    - suppress trailing newline
+//   -e    - interpret backslash escapes in the arguments, as echo -e does:
+//           \a \b \c \e \f \n \r \t \v \\ \0nnn and \xHH
+//   -E    - do not interpret backslash escapes (default)
+//   -f    - forward the contents of a file to stderr instead ('-' is stdin)
+//   -p    - start every line, written or forwarded, with the given prefix
+//   -l    - with -f or '-', write whole lines only, in chunks of at most
+//           PIPE_BUF bytes, so concurrent writers never tear each other's lines
+//   -     - as the only argument, forward stdin (like -f -)
+//   -t    - start lines with the local time in ISO-8601, to the microsecond
+//   -T    - start lines with the CLOCK_MONOTONIC time in seconds.microseconds
+//   -L    - tag lines with the given level (e.g. INFO, WARN)
+//   -P    - tag lines with the process id
+//   -o    - write text (default), kv (key="value" pairs) or json (one object
+//           per line) records, with the message in a msg field
+//
+// plain forwarding is zero-copy where the kernel allows it: splice() when
+// either end is a pipe, sendfile() from a regular file, and a read/write
+// loop through a large buffer otherwise
+//
+//   build: gcc -O2 -o errcho errcho.c
+//
+// the same source also builds as a bash loadable builtin, which saves the
+// fork, exec and dynamic linking of every call from a script loop (needs the
+// bash development headers, e.g. from bash-builtins or bash-devel):
+//
+//   gcc -O2 -shared -fPIC -DERRCHO_BUILTIN -o errcho.so errcho.c
+//       -I/usr/include/bash -I/usr/include/bash/include
+//       -I/usr/include/bash/builtins
+//   enable -f ./errcho.so errcho
+//
+// errcho-bench.sh compares the builtin, this binary and 'echo >&2'
+//
+// a minimal-startup build leaves out the C library altogether: a static
+// binary with its own _start and raw system calls, so exec maps only this
+// file's pages and nothing runs before the line is written (x86_64 and
+// aarch64). it reads argv as the getopt() of the full build does, takes -n,
+// -e and -E, and refuses the stream and log options, which need stdio and
+// the clock:
+//
+//   gcc -O2 -static -nostdlib -ffreestanding -fno-stack-protector -fno-pie
+//       -no-pie -fno-tree-loop-distribute-patterns -DERRCHO_MINIMAL
+//       -o errcho-min errcho.c
+//
+// the Makefile builds the normal, static and minimal variants, and make bench
+// compares their startup with startbench
+//
+// a line of up to PIPE_BUF bytes goes out in a single write(), so lines from
+// concurrent writers sharing a pipe never interleave; longer lines are
+// gathered into as few writev() calls as possible
 //
 
+#if !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+
+#if defined(ERRCHO_BUILTIN)
+#include "loadables.h"
+#endif
+
+#if defined(ERRCHO_MINIMAL)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
 
 #define noop (void)0
 
-static FILE * stream = NULL;
+#if !defined(IOV_MAX)
+#define IOV_MAX 1024
+#endif
+
+// bytes read at a time when forwarding a stream through a buffer
+#define STREAM_BUFSZ (1 << 16)
+
+// bytes moved per splice()/sendfile() call
+#define STREAM_CHUNK (1 << 20)
 
-void next(int *i, int argc)
+// -o record formats
+#define FORMAT_TEXT 0
+#define FORMAT_KV   1
+#define FORMAT_JSON 2
+
+// -t/-T timestamp clocks
+#define STAMP_NONE 0
+#define STAMP_ISO  1
+#define STAMP_MONO 2
+
+static int stream = STDERR_FILENO;
+
+// what each line is wrapped in
+struct logfmt
+{
+  int         format;
+  int         stamp;
+  int         pid;
+  const char *level;
+  size_t      levellen;
+  const char *prefix;
+  size_t      prefixlen;
+};
+
+// the whole seconds of the last timestamp, rendered once per second so that
+// only the microseconds are formatted for every line
+struct clockcache
+{
+  int    stamp;
+  time_t sec;
+  size_t len;
+  char   text[40];
+  char   zone[24];
+};
+
+// forwarding state for a stream that is prefixed or cut into whole lines
+struct relay
 {
-  if (++(*i) < argc)
+  int                  fd;
+  const struct logfmt *fmt;
+  size_t               limit;     // largest chunk handed to one write()
+  size_t               used;
+  int                  linestart;
+  char                 out[STREAM_BUFSZ];
+};
+
+// a buffer that grows as needed and is kept for later calls
+struct buffer
+{
+  char   *data;
+  size_t  size;
+};
+
+#if !defined(ERRCHO_MINIMAL)
+static char              INBUF[STREAM_BUFSZ];
+static struct relay      RELAY;
+static struct clockcache CLOCKCACHE;
+#endif
+static struct buffer     LINEBUF;
+
+#if defined(ERRCHO_MINIMAL)
+
+// the minimal build's runtime: the entry point, system calls, and the few C
+// library functions the write path calls, so that nothing else is linked in
+
+static int ERRNO;
+
+#if defined(__x86_64__)
+
+// the kernel starts us with argc at the stack pointer and argv above it
+__asm__(
+  ".text\n"
+  ".global _start\n"
+  "_start:\n"
+  "  xor  %ebp, %ebp\n"
+  "  mov  %rsp, %rdi\n"
+  "  and  $-16, %rsp\n"
+  "  call start\n"
+  "  hlt\n");
+
+long sys(long n, long a, long b, long c, long d, long e, long f)
+{
+  register long r10 __asm__("r10") = d;
+  register long r8  __asm__("r8")  = e;
+  register long r9  __asm__("r9")  = f;
+  long          ret = 0;
+
+  __asm__ volatile ("syscall"
+    : "=a"(ret)
+    : "a"(n), "D"(a), "S"(b), "d"(c), "r"(r10), "r"(r8), "r"(r9)
+    : "rcx", "r11", "memory");
+
+  return ret;
+}
+
+#elif defined(__aarch64__)
+
+__asm__(
+  ".text\n"
+  ".global _start\n"
+  "_start:\n"
+  "  mov  x29, #0\n"
+  "  mov  x30, #0\n"
+  "  mov  x0, sp\n"
+  "  and  sp, x0, #-16\n"
+  "  bl   start\n");
+
+long sys(long n, long a, long b, long c, long d, long e, long f)
+{
+  register long x8 __asm__("x8") = n;
+  register long x0 __asm__("x0") = a;
+  register long x1 __asm__("x1") = b;
+  register long x2 __asm__("x2") = c;
+  register long x3 __asm__("x3") = d;
+  register long x4 __asm__("x4") = e;
+  register long x5 __asm__("x5") = f;
+
+  __asm__ volatile ("svc #0"
+    : "+r"(x0)
+    : "r"(x8), "r"(x1), "r"(x2), "r"(x3), "r"(x4), "r"(x5)
+    : "memory");
+
+  return x0;
+}
+
+#else
+#error "ERRCHO_MINIMAL needs x86_64 or aarch64; build without it"
+#endif
+
+// a system call's result, or -1 with errno set from its error
+long checked(long ret)
+{
+  if (ret < 0 && ret > -4096)
   {
-    fputc(' ', stream);
+    ERRNO = (int)-ret;
+    return -1;
   }
+
+  return ret;
 }
 
-int main(int argc, char *argv[])
+int *__errno_location(void)
+{
+  return &ERRNO;
+}
+
+ssize_t write(int fd, const void *buf, size_t len)
+{
+  return checked(sys(SYS_write, fd, (long)buf, (long)len, 0, 0, 0));
+}
+
+ssize_t writev(int fd, const struct iovec *iov, int count)
+{
+  return checked(sys(SYS_writev, fd, (long)iov, count, 0, 0, 0));
+}
+
+size_t strlen(const char *s)
+{
+  const char *p = s;
+
+  while ('\0' != *p)
+    ++p;
+
+  return (size_t)(p - s);
+}
+
+char *strchr(const char *s, int c)
+{
+  for (; (char)c != *s; ++s)
+  {
+    if ('\0' == *s)
+      return NULL;
+  }
+
+  return (char *)s;
+}
+
+void *memcpy(void *dst, const void *src, size_t len)
+{
+  char       *d = dst;
+  const char *s = src;
+
+  while (len-- > 0)
+    *d++ = *s++;
+
+  return dst;
+}
+
+void *memmove(void *dst, const void *src, size_t len)
+{
+  char       *d = dst;
+  const char *s = src;
+
+  if (d <= s)
+    return memcpy(dst, src, len);
+  while (len-- > 0)
+    d[len] = s[len];
+
+  return dst;
+}
+
+void *memset(void *dst, int c, size_t len)
+{
+  char *d = dst;
+
+  while (len-- > 0)
+    *d++ = (char)c;
+
+  return dst;
+}
+
+// every allocation is a mapping of its own with the size in front; the
+// write path makes one or two per run at most
+#define ALLOC_HEAD 16
+
+void *malloc(size_t size)
+{
+  long p = checked(sys(SYS_mmap, 0, (long)(size + ALLOC_HEAD), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+
+  if (p < 0)
+    return NULL;
+  *(size_t *)p = size;
+
+  return (char *)p + ALLOC_HEAD;
+}
+
+void free(void *ptr)
+{
+  char *p = (char *)ptr - ALLOC_HEAD;
+
+  if (NULL != ptr)
+    (void)sys(SYS_munmap, (long)p, (long)(*(size_t *)p + ALLOC_HEAD), 0, 0, 0, 0);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+  size_t  old  = NULL != ptr ? *(size_t *)((char *)ptr - ALLOC_HEAD) : 0;
+  void   *grow = NULL;
+
+  if (NULL != ptr && size <= old)
+    return ptr;
+  if (NULL != (grow = malloc(size)) && NULL != ptr)
+  {
+    memcpy(grow, ptr, old);
+    free(ptr);
+  }
+
+  return grow;
+}
+
+#endif
+
+// writes all of buf, resuming after signals and short writes
+int writeall(int fd, const char *buf, size_t len)
+{
+  ssize_t n = 0;
+
+  while (len > 0)
+  {
+    if ((n = write(fd, buf, len)) < 0)
+    {
+      if (EINTR == errno)
+        continue;
+      return -1;
+    }
+    buf += n;
+    len -= (size_t)n;
+  }
+
+  return 0;
+}
+
+// writes all of the iovecs, at most IOV_MAX per call, resuming after signals
+// and short writes. the iovecs are consumed.
+int writevall(int fd, struct iovec *iov, int count)
+{
+  ssize_t n = 0;
+
+  while (count > 0)
+  {
+    if ((n = writev(fd, iov, count < IOV_MAX ? count : IOV_MAX)) < 0)
+    {
+      if (EINTR == errno)
+        continue;
+      return -1;
+    }
+    for (; count > 0 && (size_t)n >= iov->iov_len; ++iov, --count)
+    {
+      n -= (ssize_t)iov->iov_len;
+    }
+    if (count > 0)
+    {
+      iov->iov_base  = (char *)iov->iov_base + n;
+      iov->iov_len  -= (size_t)n;
+    }
+  }
+
+  return 0;
+}
+
+// writes the words separated by spaces, and a newline if asked, as one line
+int emit(int fd, char *word[], int count, int newline)
+{
+  char          line[PIPE_BUF];
+  struct iovec *iov    = NULL;
+  size_t        total  = newline ? 1 : 0;
+  size_t        len    = 0;
+  size_t        at     = 0;
+  int           status = 0;
+  int           n      = 0;
+  int           i      = 0;
+
+  for (i = 0; i < count && total <= sizeof(line); ++i)
+  {
+    total += strlen(word[i]) + (i > 0 ? 1 : 0);
+  }
+
+  // the common case: copy into one buffer for a single atomic write
+  if (total <= sizeof(line))
+  {
+    for (i = 0; i < count; ++i)
+    {
+      if (i > 0)
+        line[at++] = ' ';
+      len  = strlen(word[i]);
+      memcpy(line + at, word[i], len);
+      at  += len;
+    }
+    if (newline)
+      line[at++] = '\n';
+
+    return writeall(fd, line, at);
+  }
+
+  if (NULL == (iov = malloc(2 * (size_t)count * sizeof(*iov) + sizeof(*iov))))
+  {
+    return -1;
+  }
+
+  for (i = 0; i < count; ++i)
+  {
+    if (i > 0)
+    {
+      iov[n].iov_base = " ";
+      iov[n++].iov_len = 1;
+    }
+    iov[n].iov_base = word[i];
+    iov[n++].iov_len = strlen(word[i]);
+  }
+  if (newline)
+  {
+    iov[n].iov_base = "\n";
+    iov[n++].iov_len = 1;
+  }
+
+  status = writevall(fd, iov, n);
+  free(iov);
+
+  return status;
+}
+
+#if !defined(ERRCHO_MINIMAL)
+
+// renders the current time for -t or -T at dst, returning its end
+char *timestamp(char *dst, const int stamp)
+{
+  struct clockcache *c   = &CLOCKCACHE;
+  struct timespec    ts;
+  struct tm          tm;
+  long               off = 0;
+  long               us  = 0;
+  int                i   = 0;
+
+  (void)clock_gettime(STAMP_MONO == stamp ? CLOCK_MONOTONIC : CLOCK_REALTIME, &ts);
+
+  if (stamp != c->stamp || ts.tv_sec != c->sec)
+  {
+    c->stamp   = stamp;
+    c->sec     = ts.tv_sec;
+    c->zone[0] = '\0';
+    if (STAMP_MONO == stamp)
+    {
+      c->len = (size_t)snprintf(c->text, sizeof(c->text), "%lld", (long long)ts.tv_sec);
+    }
+    else
+    {
+      (void)localtime_r(&ts.tv_sec, &tm);
+      c->len = strftime(c->text, sizeof(c->text), "%Y-%m-%dT%H:%M:%S", &tm);
+      off    = tm.tm_gmtoff / 60;
+      (void)snprintf(c->zone, sizeof(c->zone), "%c%02ld:%02ld", off < 0 ? '-' : '+', labs(off) / 60, labs(off) % 60);
+    }
+  }
+
+  memcpy(dst, c->text, c->len);
+  dst   += c->len;
+  dst[0] = '.';
+  for (us = ts.tv_nsec / 1000, i = 6; i > 0; --i, us /= 10)
+  {
+    dst[i] = (char)('0' + us % 10);
+  }
+  dst += 7;
+
+  for (i = 0; '\0' != c->zone[i]; ++i)
+  {
+    *dst++ = c->zone[i];
+  }
+
+  return dst;
+}
+
+// renders an unsigned decimal at dst, returning its end
+char *decimal(char *dst, unsigned long value)
+{
+  char   digits[24];
+  size_t n = 0;
+
+  do
+  {
+    digits[n++] = (char)('0' + value % 10);
+  }
+  while (0 != (value /= 10));
+
+  while (n > 0)
+  {
+    *dst++ = digits[--n];
+  }
+
+  return dst;
+}
+
+// copies len bytes of s to dst escaped for a double-quoted json or kv
+// string, returning the end; at most 6 bytes are written per byte of s
+char *escape(char *dst, const char *s, size_t len)
+{
+  static const char HEX[] = "0123456789abcdef";
+
+  unsigned char ch = 0;
+
+  for (; len > 0; --len)
+  {
+    ch = (unsigned char)*s++;
+    if ('"' == ch || '\\' == ch)
+    {
+      *dst++ = '\\';
+      *dst++ = (char)ch;
+    }
+    else if ('\n' == ch || '\t' == ch || '\r' == ch)
+    {
+      *dst++ = '\\';
+      *dst++ = '\n' == ch ? 'n' : '\t' == ch ? 't' : 'r';
+    }
+    else if (ch < 0x20 || 0x7f == ch)
+    {
+      memcpy(dst, "\\u00", 4);
+      dst[4]  = HEX[ch >> 4];
+      dst[5]  = HEX[ch & 0xf];
+      dst    += 6;
+    }
+    else
+    {
+      *dst++ = (char)ch;
+    }
+  }
+
+  return dst;
+}
+
+// the largest record() output for a message of len bytes
+size_t recordmax(const struct logfmt *f, size_t len)
+{
+  if (FORMAT_TEXT == f->format)
+    return 64 + f->levellen + f->prefixlen + len;
+
+  return 128 + 6 * (f->levellen + f->prefixlen + len);
+}
+
+// starts a kv or json field, separating it from the previous one
+char *field(char *dst, const char *name, const int json, const int first)
+{
+  if (!first)
+    *dst++ = json ? ',' : ' ';
+  if (json)
+    *dst++ = '"';
+  memcpy(dst, name, strlen(name));
+  dst += strlen(name);
+  if (json)
+    *dst++ = '"';
+  *dst++ = json ? ':' : '=';
+
+  return dst;
+}
+
+// renders a line at dst and returns its length. text lines get the fields
+// in front, at the start of a line only (a long line may arrive in pieces),
+// and the message as is; kv and json lines are always whole records, with
+// the prefix and message escaped in a msg field. dst needs recordmax() bytes.
+size_t record(char *dst, const struct logfmt *f, const char *msg, size_t len, const int start, const int newline)
+{
+  char *p    = dst;
+  int   json = FORMAT_JSON == f->format;
+
+  if (FORMAT_TEXT == f->format)
+  {
+    if (start)
+    {
+      if (STAMP_NONE != f->stamp)
+      {
+        p    = timestamp(p, f->stamp);
+        *p++ = ' ';
+      }
+      if (NULL != f->level)
+      {
+        memcpy(p, f->level, f->levellen);
+        p    += f->levellen;
+        *p++  = ' ';
+      }
+      if (f->pid)
+      {
+        *p++ = '[';
+        p    = decimal(p, (unsigned long)getpid());
+        *p++ = ']';
+        *p++ = ' ';
+      }
+      memcpy(p, f->prefix, f->prefixlen);
+      p += f->prefixlen;
+    }
+    memcpy(p, msg, len);
+    p += len;
+  }
+  else
+  {
+    if (json)
+      *p++ = '{';
+    if (STAMP_NONE != f->stamp)
+    {
+      p = field(p, "ts", json, p == dst + json);
+      if (json && STAMP_ISO == f->stamp)
+        *p++ = '"';
+      p = timestamp(p, f->stamp);
+      if (json && STAMP_ISO == f->stamp)
+        *p++ = '"';
+    }
+    if (NULL != f->level)
+    {
+      p    = field(p, "level", json, p == dst + json);
+      *p++ = '"';
+      p    = escape(p, f->level, f->levellen);
+      *p++ = '"';
+    }
+    if (f->pid)
+    {
+      p = field(p, "pid", json, p == dst + json);
+      p = decimal(p, (unsigned long)getpid());
+    }
+    p    = field(p, "msg", json, p == dst + json);
+    *p++ = '"';
+    p    = escape(p, f->prefix, f->prefixlen);
+    p    = escape(p, msg, len);
+    *p++ = '"';
+    if (json)
+      *p++ = '}';
+  }
+
+  if (newline)
+    *p++ = '\n';
+
+  return (size_t)(p - dst);
+}
+
+#endif
+
+// makes room for at least size bytes in b
+int reserve(struct buffer *b, size_t size)
+{
+  char *data = NULL;
+
+  if (size <= b->size)
+    return 0;
+  if (NULL == (data = realloc(b->data, size)))
+    return -1;
+
+  b->data = data;
+  b->size = size;
+
+  return 0;
+}
+
+// copies the words separated by spaces to dst and returns the length
+size_t join(char *dst, char *word[], int count)
+{
+  size_t at  = 0;
+  size_t len = 0;
+  int    i   = 0;
+
+  for (i = 0; i < count; ++i)
+  {
+    if (i > 0)
+      dst[at++] = ' ';
+    len  = strlen(word[i]);
+    memcpy(dst + at, word[i], len);
+    at  += len;
+  }
+
+  return at;
+}
+
+// the value of a hex digit, or -1
+int hexdigit(const char ch)
+{
+  if (ch >= '0' && ch <= '9')
+    return ch - '0';
+  if (ch >= 'a' && ch <= 'f')
+    return ch - 'a' + 10;
+  if (ch >= 'A' && ch <= 'F')
+    return ch - 'A' + 10;
+
+  return -1;
+}
+
+// copies the words separated by spaces to dst like join(), decoding the
+// escapes of echo -e, and returns the length. the text between backslashes
+// is found with strchr() and copied in runs. *stop is set at \c, which ends
+// all output, newline included. dst needs as many bytes as join() would use.
+size_t unescape(char *dst, char *word[], int count, int *stop)
+{
+  const char *s  = NULL;
+  const char *bs = NULL;
+  char       *p  = dst;
+  int         v  = 0;
+  int         d  = 0;
+  int         n  = 0;
+  int         i  = 0;
+
+  *stop = 0;
+
+  for (i = 0; i < count; ++i)
+  {
+    if (i > 0)
+      *p++ = ' ';
+
+    for (s = word[i]; NULL != (bs = strchr(s, '\\')); s = bs)
+    {
+      memcpy(p, s, (size_t)(bs - s));
+      p += bs - s;
+      switch (*++bs)
+      {
+        case 'a':  *p++ = '\a';   ++bs; break;
+        case 'b':  *p++ = '\b';   ++bs; break;
+        case 'e':
+        case 'E':  *p++ = '\033'; ++bs; break;
+        case 'f':  *p++ = '\f';   ++bs; break;
+        case 'n':  *p++ = '\n';   ++bs; break;
+        case 'r':  *p++ = '\r';   ++bs; break;
+        case 't':  *p++ = '\t';   ++bs; break;
+        case 'v':  *p++ = '\v';   ++bs; break;
+        case '\\': *p++ = '\\';   ++bs; break;
+
+        case 'c':
+          *stop = 1;
+          return (size_t)(p - dst);
+
+        case '0':
+          for (++bs, v = 0, n = 0; n < 3 && *bs >= '0' && *bs <= '7'; ++n)
+          {
+            v = v * 8 + *bs++ - '0';
+          }
+          *p++ = (char)v;
+          break;
+
+        case 'x':
+          for (++bs, v = 0, n = 0; n < 2 && (d = hexdigit(*bs)) >= 0; ++n, ++bs)
+          {
+            v = v * 16 + d;
+          }
+          if (n > 0)
+          {
+            *p++ = (char)v;
+          }
+          else
+          {
+            *p++ = '\\';
+            *p++ = 'x';
+          }
+          break;
+
+        case '\0':
+          *p++ = '\\';
+          break;
+
+        default:
+          *p++ = '\\';
+          *p++ = *bs++;
+          break;
+      }
+    }
+
+    n  = (int)strlen(s);
+    memcpy(p, s, (size_t)n);
+    p += n;
+  }
+
+  return (size_t)(p - dst);
+}
+
+#if !defined(ERRCHO_MINIMAL)
+
+// writes msg as one record with the fields asked for, in a single write
+// when it fits in PIPE_BUF. in text records every line msg holds gets the
+// fields, as the lines of a forwarded stream do; kv and json records keep
+// the newlines escaped in their one msg field.
+int emitrecord(int fd, const struct logfmt *f, const char *msg, size_t len, int newline)
+{
+  char        line[PIPE_BUF];
+  char       *buf    = line;
+  const char *eol    = NULL;
+  size_t      lines  = 1;
+  size_t      n      = 0;
+  size_t      at     = 0;
+  int         status = 0;
+
+  for (eol = msg; FORMAT_TEXT == f->format && NULL != (eol = memchr(eol, '\n', len - (size_t)(eol - msg))); ++eol)
+    ++lines;
+
+  // text copies msg as is, one set of fields per line; kv and json escape
+  // it, up to 6 bytes for each
+  n = FORMAT_TEXT == f->format ? lines * recordmax(f, 0) + len : recordmax(f, len);
+  if (n > sizeof(line) && NULL == (buf = malloc(n)))
+    return -1;
+
+  if (FORMAT_TEXT != f->format)
+  {
+    n = record(buf, f, msg, len, 1, newline);
+  }
+  else
+  {
+    // a line after the last newline only starts if it has text, or the
+    // record's own newline ends it
+    for (n = 0; NULL != (eol = memchr(msg + at, '\n', len - at)); )
+    {
+      n  += record(buf + n, f, msg + at, (size_t)(eol - msg) - at, 1, 1);
+      at  = (size_t)(eol - msg) + 1;
+    }
+    if (at < len || newline || 1 == lines)
+      n += record(buf + n, f, msg + at, len - at, 1, newline);
+  }
+  status = writeall(fd, buf, n);
+
+  if (line != buf)
+    free(buf);
+
+  return status;
+}
+
+// copies in to out unchanged until end of file, preferring splice() and
+// sendfile() and falling back to read()/write() where they are refused
+int forward(int in, int out)
+{
+  struct stat ist;
+  struct stat ost;
+  ssize_t     n     = 0;
+  int         moved = 0;
+
+  if (0 == fstat(in, &ist) && 0 == fstat(out, &ost))
+  {
+    if (S_ISFIFO(ist.st_mode) || S_ISFIFO(ost.st_mode))
+    {
+      while (0 != (n = splice(in, NULL, out, NULL, STREAM_CHUNK, SPLICE_F_MOVE | SPLICE_F_MORE)))
+      {
+        if (n < 0)
+        {
+          if (EINTR == errno)
+            continue;
+          if (moved || (EINVAL != errno && ENOSYS != errno))
+            return -1;
+          break;
+        }
+        moved = 1;
+      }
+      if (0 == n)
+        return 0;
+    }
+    else if (S_ISREG(ist.st_mode))
+    {
+      while (0 != (n = sendfile(out, in, NULL, STREAM_CHUNK)))
+      {
+        if (n < 0)
+        {
+          if (EINTR == errno)
+            continue;
+          if (moved || (EINVAL != errno && ENOSYS != errno))
+            return -1;
+          break;
+        }
+        moved = 1;
+      }
+      if (0 == n)
+        return 0;
+    }
+  }
+
+  while (0 != (n = read(in, INBUF, sizeof(INBUF))))
+  {
+    if (n < 0)
+    {
+      if (EINTR == errno)
+        continue;
+      return -1;
+    }
+    if (0 != writeall(out, INBUF, (size_t)n))
+      return -1;
+  }
+
+  return 0;
+}
+
+// writes out whatever the relay has gathered
+int relayflush(struct relay *r)
 {
-  int newline = 1;
-  int c       = 0; 
-  int i       = 0;
+  int status = writeall(r->fd, r->out, r->used);
+
+  r->used = 0;
+
+  return status;
+}
+
+// adds a line, or a piece of one too long to buffer when newline is 0, to
+// the relay as a record. records are never split across writes unless they
+// are longer than the chunk limit by themselves.
+int relayput(struct relay *r, const char *p, size_t len, int newline)
+{
+  char   *buf    = NULL;
+  size_t  need   = recordmax(r->fmt, len);
+  size_t  n      = 0;
+  int     status = 0;
+
+  // kv and json pieces are complete records of their own
+  if (FORMAT_TEXT != r->fmt->format)
+    newline = 1;
+
+  if (need > sizeof(r->out))
+  {
+    if (0 != relayflush(r) || NULL == (buf = malloc(need)))
+      return -1;
+    n      = record(buf, r->fmt, p, len, r->linestart, newline);
+    status = writeall(r->fd, buf, n);
+    free(buf);
+    r->linestart = newline;
+    return status;
+  }
+
+  if (r->used + need > sizeof(r->out) && 0 != relayflush(r))
+    return -1;
+
+  n            = record(r->out + r->used, r->fmt, p, len, r->linestart, newline);
+  r->linestart = newline;
+
+  // a record that would cross the chunk limit starts the next chunk
+  if (r->used > 0 && r->used + n > r->limit)
+  {
+    if (0 != writeall(r->fd, r->out, r->used))
+      return -1;
+    memmove(r->out, r->out + r->used, n);
+    r->used = 0;
+  }
+  r->used += n;
+
+  return r->used >= r->limit ? relayflush(r) : 0;
+}
+
+// copies in to out line by line, wrapping each line as fmt asks and, when
+// atomic, cutting the output at line ends into chunks of PIPE_BUF bytes
+int relay(int in, int out, const struct logfmt *fmt, int atomic)
+{
+  struct relay *r    = &RELAY;
+  const char   *p    = NULL;
+  const char   *nl   = NULL;
+  size_t        have = 0;
+  ssize_t       n    = 0;
+
+  r->fd        = out;
+  r->fmt       = fmt;
+  r->limit     = atomic ? PIPE_BUF : sizeof(r->out);
+  r->used      = 0;
+  r->linestart = 1;
+
+  for (;;)
+  {
+    if ((n = read(in, INBUF + have, sizeof(INBUF) - have)) < 0)
+    {
+      if (EINTR == errno)
+        continue;
+      return -1;
+    }
+    if (0 == n)
+      break;
+    have += (size_t)n;
+
+    for (p = INBUF; NULL != (nl = memchr(p, '\n', (size_t)(INBUF + have - p))); p = nl + 1)
+    {
+      if (0 != relayput(r, p, (size_t)(nl - p), 1))
+        return -1;
+    }
+
+    // keep the unfinished line for the next read, unless it fills the buffer
+    have -= (size_t)(p - INBUF);
+    if (sizeof(INBUF) == have)
+    {
+      if (0 != relayput(r, INBUF, have, 0))
+        return -1;
+      have = 0;
+    }
+    memmove(INBUF, p, have);
+  }
+
+  if (have > 0 && 0 != relayput(r, INBUF, have, 0))
+    return -1;
+
+  return relayflush(r);
+}
+
+// forwards a file, or stdin for '-', to fd; plainly when nothing needs to
+// be added or cut, otherwise line by line
+int relayfile(int fd, const char *path, const struct logfmt *fmt, int logging, int atomic)
+{
+  char msg[PIPE_BUF];
+  int  in     = STDIN_FILENO;
+  int  status = 0;
+
+  if (0 != strcmp(path, "-") && (in = open(path, O_RDONLY | O_CLOEXEC)) < 0)
+  {
+    (void)snprintf(msg, sizeof(msg), "errcho: %s: %s\n", path, strerror(errno));
+    (void)writeall(fd, msg, strlen(msg));
+    return -1;
+  }
+
+  if (!logging && !atomic)
+    status = forward(in, fd);
+  else
+    status = relay(in, fd, fmt, atomic);
+
+  if (STDIN_FILENO != in)
+    (void)close(in);
+
+  return status;
+}
+
+#endif
+
+#if defined(ERRCHO_MINIMAL)
+
+// set from the environment by start(): GNU getopt() then stops at the first
+// word that is not an option instead of permuting
+static int POSIXLY = 0;
+
+// the minimal build's errcho(): parses argv the way GNU getopt() does in the
+// full build, so that both print the same for the same words. options may
+// follow the words (errcho foo -n), -- ends them, a lone - is a word, and
+// letters errcho does not know are ignored. the words are gathered in order
+// at the front of argv.
+int errcho(int argc, char *argv[])
+{
+  static const char stdinrefused[] = "errcho: - needs the full build\n";
+
+  char   refused[] = "errcho: -? needs the full build\n";
+  char **word      = argv + 1;
+  char  *opt       = NULL;
+  size_t len       = 0;
+  int    options   = 1;
+  int    newline   = 1;
+  int    escapes   = 0;
+  int    stop      = 0;
+  int    count     = 0;
+  int    i         = 1;
+
+  for (; i < argc; ++i)
+  {
+    if (!options || '-' != argv[i][0] || '\0' == argv[i][1])
+    {
+      word[count++] = argv[i];
+      options       = options && !POSIXLY;
+      continue;
+    }
+    if ('-' == argv[i][1] && '\0' == argv[i][2])
+    {
+      options = 0;
+      continue;
+    }
+
+    for (opt = argv[i] + 1; '\0' != *opt; ++opt)
+    {
+      if ('n' == *opt)
+        newline = 0;
+      else if ('e' == *opt)
+        escapes = 1;
+      else if ('E' == *opt)
+        escapes = 0;
+      else if (NULL != strchr("fpltTLPo", *opt))
+        break;
+    }
+
+    if ('\0' != *opt)
+    {
+      refused[9] = *opt;
+      (void)writeall(STDERR_FILENO, refused, sizeof(refused) - 1);
+      return 2;
+    }
+  }
+
+  if (1 == count && '-' == word[0][0] && '\0' == word[0][1])
+  {
+    (void)writeall(STDERR_FILENO, stdinrefused, sizeof(stdinrefused) - 1);
+    return 2;
+  }
+
+  // words without a backslash need no decoding and are written in place
+  for (i = 0; escapes && i < count && NULL == strchr(word[i], '\\'); ++i)
+    ;
+
+  if (!escapes || i == count)
+  {
+    return 0 != emit(stream, word, count, newline) ? 1 : 0;
+  }
+
+  for (i = 0; i < count; ++i)
+  {
+    len += strlen(word[i]) + 1;
+  }
+  if (0 != reserve(&LINEBUF, len + 1))
+  {
+    return 1;
+  }
+
+  len = unescape(LINEBUF.data, word, count, &stop);
+  if (newline && !stop)
+  {
+    LINEBUF.data[len++] = '\n';
+  }
+
+  return 0 != writeall(stream, LINEBUF.data, len) ? 1 : 0;
+}
+
+#else
+
+// parses the options and writes the line; shared by main() and the builtin
+int errcho(int argc, char *argv[])
+{
+  struct logfmt fmt     = { FORMAT_TEXT, STAMP_NONE, 0, NULL, 0, "", 0 };
+  const char   *file    = NULL;
+  int           newline = 1;
+  int           atomic  = 0;
+  char        **word    = NULL;
+  size_t        len     = 0;
+  int           count   = 0;
+  int           logging = 0;
+  int           escapes = 0;
+  int           stop    = 0;
+  int           i       = 0;
+  int           c       = 0;
 
-  stream = stderr;
   opterr = 0;
+  optind = 0; // full rescan, as the builtin calls this once per invocation
 
-  while (-1 != (c = getopt(argc, argv, "n")))
+  while (-1 != (c = getopt(argc, argv, "neEf:p:ltTL:Po:")))
   {
     switch (c)
     {
@@ -35,20 +1159,200 @@ int main(int argc, char *argv[])
         newline = 0;
         break;
 
+      case 'e':
+        escapes = 1;
+        break;
+
+      case 'E':
+        escapes = 0;
+        break;
+
+      case 'f':
+        file = optarg;
+        break;
+
+      case 'p':
+        fmt.prefix    = optarg;
+        fmt.prefixlen = strlen(optarg);
+        break;
+
+      case 'l':
+        atomic = 1;
+        break;
+
+      case 't':
+        fmt.stamp = STAMP_ISO;
+        break;
+
+      case 'T':
+        fmt.stamp = STAMP_MONO;
+        break;
+
+      case 'L':
+        fmt.level    = optarg;
+        fmt.levellen = strlen(optarg);
+        break;
+
+      case 'P':
+        fmt.pid = 1;
+        break;
+
+      case 'o':
+        if (0 == strcmp(optarg, "kv"))
+          fmt.format = FORMAT_KV;
+        else if (0 == strcmp(optarg, "json"))
+          fmt.format = FORMAT_JSON;
+        else
+          fmt.format = FORMAT_TEXT;
+        break;
+
       default:
         break;
     }
   }
 
-  for (i = optind; i < argc; next(&i, argc))
+  if (NULL == file && optind + 1 == argc && 0 == strcmp(argv[optind], "-"))
+  {
+    file = "-";
+  }
+
+  logging = FORMAT_TEXT != fmt.format || STAMP_NONE != fmt.stamp || fmt.pid || NULL != fmt.level || fmt.prefixlen > 0;
+
+  if (NULL != file)
+  {
+    return 0 != relayfile(stream, file, &fmt, logging, atomic) ? 1 : 0;
+  }
+
+  word  = argv + optind;
+  count = argc - optind;
+
+  // words without a backslash need no decoding and are written in place
+  for (i = 0; escapes && i < count && NULL == strchr(word[i], '\\'); ++i)
+    ;
+  escapes = escapes && i < count;
+
+  if (!logging && !escapes)
+  {
+    return 0 != emit(stream, word, count, newline) ? 1 : 0;
+  }
+
+  for (i = 0; i < count; ++i)
+  {
+    len += strlen(word[i]) + 1;
+  }
+  if (0 != reserve(&LINEBUF, len + 1))
+  {
+    return 1;
+  }
+
+  if (escapes)
+  {
+    len = unescape(LINEBUF.data, word, count, &stop);
+    if (stop)
+      newline = 0;
+  }
+  else
+  {
+    len = join(LINEBUF.data, word, count);
+  }
+
+  if (logging)
   {
-    fprintf(stream, "%s", argv[i]);
+    return 0 != emitrecord(stream, &fmt, LINEBUF.data, len, newline) ? 1 : 0;
   }
 
   if (newline)
   {
-    fputc('\n', stream);
+    LINEBUF.data[len++] = '\n';
   }
 
-  return 0;
+  return 0 != writeall(stream, LINEBUF.data, len) ? 1 : 0;
+}
+
+#endif
+
+#if defined(ERRCHO_BUILTIN)
+
+int errcho_builtin(WORD_LIST *list)
+{
+  char **argv   = NULL;
+  int    argc   = 0;
+  int    status = 0;
+
+  // slot 0 is left for the command name, as getopt() expects; the count
+  // returned includes it
+  argv    = strvec_from_word_list(list, 0, 1, &argc);
+  argv[0] = "errcho";
+  status  = errcho(argc, argv);
+  xfree(argv);
+
+  return 0 == status ? EXECUTION_SUCCESS : EXECUTION_FAILURE;
 }
+
+char *errcho_doc[] = {
+  "Write arguments to the standard error.",
+  "",
+  "Display the ARGs, separated by a single space character and followed by a",
+  "newline, on the standard error. Lines up to PIPE_BUF bytes are written",
+  "atomically.",
+  "",
+  "Options:",
+  "  -n\tdo not append a newline",
+  "  -e\tinterpret backslash escapes in the ARGs, as echo -e does",
+  "  -E\tdo not interpret backslash escapes (default)",
+  "  -f FILE\tforward FILE ('-' for stdin) instead of writing ARGs",
+  "  -p PREFIX\tstart each line with PREFIX",
+  "  -l\twrite forwarded lines in whole-line chunks of up to PIPE_BUF",
+  "  -t\tstart each line with the local time in ISO-8601",
+  "  -T\tstart each line with the monotonic clock in seconds",
+  "  -L LEVEL\ttag each line with LEVEL",
+  "  -P\ttag each line with the process id",
+  "  -o FORMAT\twrite text, kv or json records",
+  "",
+  "A single ARG of '-' forwards the standard input.",
+  "",
+  "Exit Status:",
+  "Returns success unless a write error occurs.",
+  NULL
+};
+
+struct builtin errcho_struct = {
+  "errcho",
+  errcho_builtin,
+  BUILTIN_ENABLED,
+  errcho_doc,
+  "errcho [-neEtTP] [-L level] [-p prefix] [-o format] [-l] [-f file | - | arg ...]",
+  0
+};
+
+#elif defined(ERRCHO_MINIMAL)
+
+// entered from _start with the initial stack: argc, argv, then the
+// environment
+__attribute__((noreturn, used)) void start(long *sp)
+{
+  static const char posixly[] = "POSIXLY_CORRECT=";
+
+  char **env = (char **)(sp + 1) + sp[0] + 1;
+  size_t i   = 0;
+
+  for (; NULL != *env && !POSIXLY; ++env)
+  {
+    for (i = 0; '\0' != posixly[i] && posixly[i] == (*env)[i]; ++i)
+      ;
+    POSIXLY = '\0' == posixly[i];
+  }
+
+  (void)sys(SYS_exit_group, errcho((int)sp[0], (char **)(sp + 1)), 0, 0, 0, 0, 0);
+  for (;;)
+    ;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  return errcho(argc, argv);
+}
+
+#endif
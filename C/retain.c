@@ -0,0 +1,450 @@
+//
+// plans the rotation of backup tarballs: lists (or removes) the *.tbz files
+// in a backup directory that none of the retention schemes of
+// sysbackup/rotate.sh protects:
+//
+//   1) created within the last 7 days (including today)
+//   2) created on a sunday within the last 4 weeks (including this week)
+//   3) created on the first of the month within the last 12 months
+//      (including this month)
+//
+// a backup is named <prefix>__YYYY-MM-DD__HH-MM-SS.tbz; the keep-set is
+// computed with integer calendar arithmetic, the directory is read with a
+// single getdents64() pass, and each name's date is looked up in the sorted
+// keep-set. as in rotate.sh, a .tbz whose name does not start with a kept
+// <prefix>__YYYY-MM-DD__ is not protected, whatever its prefix.
+//
+//   build: gcc -std=gnu99 -O2 -o retain retain.c
+//
+// usage: retain -p prefix [-d YYYY-MM-DD] [-D days] [-W weeks] [-M months]
+//               [-w weekday] [-x] [-0] [-v] dir
+//   -p, --prefix  - name prefix of the backups (the os/kernel part)
+//   -d, --date    - the day to plan from (default: today, local time)
+//   -D, --days    - days of daily backups kept (default: 7)
+//   -W, --weeks   - weeks of weekly backups kept (default: 4)
+//   -M, --months  - months of monthly backups kept (default: 12)
+//   -w, --weekday - day of the weekly backups, by name or 0-6 from sunday
+//                   (default: sunday)
+//   -x, --remove  - remove the files, printing "rm -f 'path'" for each, as
+//                   rotate.sh does, instead of listing them
+//   -0, --null    - end listed paths with NUL instead of newline
+//   -v, --verbose - print the keep-set on stderr
+//
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+// bytes of directory entries fetched per getdents64() call
+#define DIRENT_BUFSZ (1 << 16)
+
+// the date part of a name after the prefix: "__YYYY-MM-DD__"
+#define DATE_FIELD_LEN 14
+
+#define KEEP_MAX 1024
+
+// the kernel's directory entry record, as returned by getdents64()
+struct linuxdirent
+{
+  uint64_t       d_ino;
+  int64_t        d_off;
+  unsigned short d_reclen;
+  unsigned char  d_type;
+  char           d_name[];
+};
+
+static const char *WEEKDAY[7] = {
+  "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday",
+};
+
+static const struct option LONGOPTS[] = {
+  { "prefix",   required_argument, NULL,  'p' },
+  { "date",     required_argument, NULL,  'd' },
+  { "days",     required_argument, NULL,  'D' },
+  { "weeks",    required_argument, NULL,  'W' },
+  { "months",   required_argument, NULL,  'M' },
+  { "weekday",  required_argument, NULL,  'w' },
+  { "remove",   no_argument,       NULL,  'x' },
+  { "null",     no_argument,       NULL,  '0' },
+  { "verbose",  no_argument,       NULL,  'v' },
+  { NULL,       0,                 NULL,   0  }
+};
+
+// days since 1970-01-01 of a date in the proleptic Gregorian calendar
+long daysfromcivil(int y, const int m, const int d)
+{
+  long era = 0;
+  long yoe = 0;
+  long doy = 0;
+  long doe = 0;
+
+  y   -= m <= 2;
+  era  = (y >= 0 ? y : y - 399) / 400;
+  yoe  = y - era * 400;
+  doy  = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  doe  = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+  return era * 146097 + doe - 719468;
+}
+
+// the date of a day count from daysfromcivil()
+void civilfromdays(long days, int *y, int *m, int *d)
+{
+  long era = 0;
+  long doe = 0;
+  long yoe = 0;
+  long doy = 0;
+  long mp  = 0;
+
+  days += 719468;
+  era   = (days >= 0 ? days : days - 146096) / 146097;
+  doe   = days - era * 146097;
+  yoe   = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  doy   = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  mp    = (5 * doy + 2) / 153;
+  *d    = (int)(doy - (153 * mp + 2) / 5 + 1);
+  *m    = (int)(mp < 10 ? mp + 3 : mp - 9);
+  *y    = (int)(yoe + era * 400 + (*m <= 2));
+}
+
+// 0 for sunday through 6 for saturday
+int weekday(const long days)
+{
+  return (int)(((days % 7) + 11) % 7); // 1970-01-01 was a thursday
+}
+
+// parses YYYY-MM-DD exactly, into a day count
+bool parsedate(const char *s, long *days)
+{
+  int y  = 0;
+  int m  = 0;
+  int d  = 0;
+  int cy = 0;
+  int cm = 0;
+  int cd = 0;
+  int i  = 0;
+
+  for (i = 0; i < 10; ++i)
+  {
+    if ((4 == i || 7 == i) ? '-' != s[i] : (s[i] < '0' || s[i] > '9'))
+      return false;
+  }
+
+  y = (s[0] - '0') * 1000 + (s[1] - '0') * 100 + (s[2] - '0') * 10 + (s[3] - '0');
+  m = (s[5] - '0') * 10 + (s[6] - '0');
+  d = (s[8] - '0') * 10 + (s[9] - '0');
+  if (m < 1 || m > 12 || d < 1 || d > 31)
+    return false;
+
+  // a day past the end of its month (2024-02-30) would roll over into the
+  // next one; the round trip catches it
+  *days = daysfromcivil(y, m, d);
+  civilfromdays(*days, &cy, &cm, &cd);
+
+  return cy == y && cm == m && cd == d;
+}
+
+int comparedays(const void *a, const void *b)
+{
+  long x = *(const long *)a;
+  long y = *(const long *)b;
+
+  return (x > y) - (x < y);
+}
+
+void printdays(const char *title, const char *prefix, const long *day, const size_t count)
+{
+  size_t i = 0;
+  int    y = 0;
+  int    m = 0;
+  int    d = 0;
+
+  fprintf(stderr, "%s:\n", title);
+  for (i = 0; i < count; ++i)
+  {
+    civilfromdays(day[i], &y, &m, &d);
+    fprintf(stderr, "  %s__%04d-%02d-%02d__\n", prefix, y, m, d);
+  }
+}
+
+// fills keep with the protected days, sorted and unique, and returns how many
+size_t keepset(long *keep, const long today, const int days, const int weeks, const int months, const int dow, const char *prefix, const bool verbose)
+{
+  long   daily[KEEP_MAX];
+  long   weekly[KEEP_MAX];
+  long   monthly[KEEP_MAX];
+  long   recent = today - ((weekday(today) - dow + 7) % 7);
+  long   month  = 0;
+  size_t count  = 0;
+  size_t i      = 0;
+  int    y      = 0;
+  int    m      = 0;
+  int    d      = 0;
+  int    n      = 0;
+
+  for (n = 0; n < days; ++n)
+  {
+    daily[n] = today - n;
+  }
+
+  // rotate.sh anchors the weeks on the last such weekday among its 7 daily
+  // backups, which is the most recent one on or before today
+  for (n = 0; n < weeks; ++n)
+  {
+    weekly[n] = recent - 7L * n;
+  }
+
+  civilfromdays(today, &y, &m, &d);
+  for (n = 0; n < months; ++n)
+  {
+    month      = (long)y * 12 + (m - 1) - n;
+    monthly[n] = daysfromcivil((int)(month / 12), (int)(month % 12) + 1, 1);
+  }
+
+  if (verbose)
+  {
+    printdays("daily", prefix, daily, (size_t)days);
+    printdays("weekly", prefix, weekly, (size_t)weeks);
+    printdays("monthly", prefix, monthly, (size_t)months);
+  }
+
+  memcpy(keep, daily, (size_t)days * sizeof(*keep));
+  memcpy(keep + days, weekly, (size_t)weeks * sizeof(*keep));
+  memcpy(keep + days + weeks, monthly, (size_t)months * sizeof(*keep));
+  count = (size_t)(days + weeks + months);
+
+  qsort(keep, count, sizeof(*keep), comparedays);
+  for (i = 0, n = 0; i < count; ++i)
+  {
+    if (0 == n || keep[n - 1] != keep[i])
+      keep[n++] = keep[i];
+  }
+
+  if (verbose)
+  {
+    printdays("all", prefix, keep, (size_t)n);
+  }
+
+  return (size_t)n;
+}
+
+// whether the name is a backup of a protected day
+bool kept(const char *name, const char *prefix, const size_t prefixlen, const long *keep, const size_t count)
+{
+  const char *date = name + prefixlen;
+  long        day  = 0;
+
+  if (0 != strncmp(name, prefix, prefixlen) || strlen(date) < DATE_FIELD_LEN)
+    return false;
+  if ('_' != date[0] || '_' != date[1] || '_' != date[12] || '_' != date[13])
+    return false;
+  if (!parsedate(date + 2, &day))
+    return false;
+
+  return NULL != bsearch(&day, keep, count, sizeof(*keep), comparedays);
+}
+
+// whether the name ends in .tbz, in any case, as find -iname matches it
+bool tarball(const char *name)
+{
+  size_t len = strlen(name);
+
+  return len >= 4 && 0 == strcasecmp(name + len - 4, ".tbz");
+}
+
+int main(int argc, char *argv[])
+{
+  // uint64_t for the alignment of the records' 64-bit fields
+  static uint64_t buf[DIRENT_BUFSZ / sizeof(uint64_t)];
+
+  struct linuxdirent *ent       = NULL;
+  struct stat         st;
+  struct tm           tm;
+  const char         *prefix    = NULL;
+  const char         *dir       = NULL;
+  const char         *sep       = "/";
+  char               *doomed    = NULL;
+  char               *more      = NULL;
+  long                keep[3 * KEEP_MAX];
+  long                today     = 0;
+  time_t              now       = time(NULL);
+  size_t              count     = 0;
+  size_t              prefixlen = 0;
+  size_t              used      = 0;
+  size_t              size      = 0;
+  size_t              len       = 0;
+  long                n         = 0;
+  long                at        = 0;
+  int                 days      = 7;
+  int                 weeks     = 4;
+  int                 months    = 12;
+  int                 dow       = 0;
+  int                 fd        = -1;
+  int                 status    = 0;
+  int                 c         = 0;
+  bool                remove    = false;
+  bool                verbose   = false;
+  char                end       = '\n';
+
+  (void)localtime_r(&now, &tm);
+  today = daysfromcivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+
+  while (-1 != (c = getopt_long(argc, argv, "p:d:D:W:M:w:x0v", LONGOPTS, NULL)))
+  {
+    switch (c)
+    {
+      case 'p':
+        prefix = optarg;
+        break;
+
+      case 'd':
+        if (!parsedate(optarg, &today) || '\0' != optarg[10])
+        {
+          fprintf(stderr, "retain: invalid --date '%s' (YYYY-MM-DD)\n", optarg);
+          return 2;
+        }
+        break;
+
+      case 'D':
+        days = atoi(optarg);
+        break;
+
+      case 'W':
+        weeks = atoi(optarg);
+        break;
+
+      case 'M':
+        months = atoi(optarg);
+        break;
+
+      case 'w':
+        for (dow = 0; dow < 7; ++dow)
+        {
+          if (0 == strncasecmp(optarg, WEEKDAY[dow], 3) && ('\0' == optarg[3] || 0 == strcasecmp(optarg, WEEKDAY[dow])))
+            break;
+        }
+        if (7 == dow && optarg[0] >= '0' && optarg[0] <= '6' && '\0' == optarg[1])
+        {
+          dow = optarg[0] - '0';
+        }
+        if (7 == dow)
+        {
+          fprintf(stderr, "retain: invalid --weekday '%s'\n", optarg);
+          return 2;
+        }
+        break;
+
+      case 'x':
+        remove = true;
+        break;
+
+      case '0':
+        end = '\0';
+        break;
+
+      case 'v':
+        verbose = true;
+        break;
+
+      default:
+        fprintf(stderr, "usage: retain -p prefix [-d YYYY-MM-DD] [-D days] [-W weeks] [-M months] [-w weekday] [-x] [-0] [-v] dir\n");
+        return 2;
+    }
+  }
+
+  if (NULL == prefix || optind + 1 != argc)
+  {
+    fprintf(stderr, "usage: retain -p prefix [-d YYYY-MM-DD] [-D days] [-W weeks] [-M months] [-w weekday] [-x] [-0] [-v] dir\n");
+    return 2;
+  }
+  if (days < 0 || days > KEEP_MAX || weeks < 0 || weeks > KEEP_MAX || months < 0 || months > KEEP_MAX)
+  {
+    fprintf(stderr, "retain: days, weeks and months must be within 0..%d\n", KEEP_MAX);
+    return 2;
+  }
+
+  dir       = argv[optind];
+  prefixlen = strlen(prefix);
+  if ('\0' != dir[0] && '/' == dir[strlen(dir) - 1])
+  {
+    sep = "";
+  }
+
+  count = keepset(keep, today, days, weeks, months, dow, prefix, verbose);
+
+  if ((fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+  {
+    fprintf(stderr, "retain: %s: %s\n", dir, strerror(errno));
+    return 1;
+  }
+
+  while ((n = syscall(SYS_getdents64, fd, buf, sizeof(buf))) > 0)
+  {
+    for (at = 0; at < n; at += ent->d_reclen)
+    {
+      ent = (struct linuxdirent *)((char *)buf + at);
+      if (!tarball(ent->d_name) || kept(ent->d_name, prefix, prefixlen, keep, count))
+        continue;
+
+      // like rm -f in rotate.sh, directories are left alone
+      if (DT_DIR == ent->d_type ||
+          (DT_UNKNOWN == ent->d_type && 0 == fstatat(fd, ent->d_name, &st, AT_SYMLINK_NOFOLLOW) && S_ISDIR(st.st_mode)))
+        continue;
+
+      if (!remove)
+      {
+        printf("%s%s%s%c", dir, sep, ent->d_name, end);
+        continue;
+      }
+
+      // removing entries while the directory is still being read can make
+      // getdents64() skip others, so the names are collected first
+      len = strlen(ent->d_name) + 1;
+      if (used + len > size)
+      {
+        size = 2 * (used + len);
+        if (NULL == (more = realloc(doomed, size)))
+        {
+          perror("realloc");
+          return 1;
+        }
+        doomed = more;
+      }
+      memcpy(doomed + used, ent->d_name, len);
+      used += len;
+    }
+  }
+  if (n < 0)
+  {
+    fprintf(stderr, "retain: %s: %s\n", dir, strerror(errno));
+    status = 1;
+  }
+
+  for (at = 0; (size_t)at < used; at += (long)strlen(doomed + at) + 1)
+  {
+    printf("rm -f '%s%s%s'\n", dir, sep, doomed + at);
+    if (0 != unlinkat(fd, doomed + at, 0) && ENOENT != errno)
+    {
+      fprintf(stderr, "retain: %s%s%s: %s\n", dir, sep, doomed + at, strerror(errno));
+      status = 1;
+    }
+  }
+
+  free(doomed);
+  (void)close(fd);
+
+  return status;
+}
@@ -0,0 +1,354 @@
+//
+// measures what it costs to start a command: runs it many times and reports
+// the wall time from exec to exit, and the instructions retired and page
+// faults taken from the exec on. the counters come from perf_event_open(),
+// attached to the forked child before it execs and enabled by the exec
+// itself, so the fork and its copy-on-write faults are left out.
+//
+//   build: gcc -std=gnu99 -O2 -o startbench startbench.c
+//
+// usage: startbench [-H] [-n runs] [-w warmup] [-l label ...] [-k] command [arg ...] [:: command [arg ...] ...]
+//   -H, --header - print the column header first
+//   -n, --runs   - timed runs of each command (default: 200)
+//   -w, --warmup - untimed runs first, to fill the page cache (default: 5)
+//   -l, --label  - name of the row, once per command in order (default: the
+//                  command)
+//   -k, --keep   - keep the command's stdout and stderr instead of sending
+//                  them to /dev/null
+//
+// several commands, separated by '::' words, are run in turn, one run of each
+// per round, so that a machine that gets slower or faster over the benchmark
+// (frequency, other load) shifts all of them alike and their rows compare.
+//
+// each row has the median and 90th percentile wall time in microseconds, the
+// median instructions retired in user space and in all (user and kernel,
+// which includes the exec), the median page faults and the largest peak RSS
+// in KiB. a counter the kernel or the CPU does not offer (instructions, in
+// most VMs) shows as '-'; without the page fault counter the faults come from
+// the child's rusage instead, fork included, and are marked with a '*'.
+//
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/perf_event.h>
+
+#define COUNTER_USER   0
+#define COUNTER_ALL    1
+#define COUNTER_FAULTS 2
+#define COUNTERS       3
+
+#define USAGE "usage: startbench [-H] [-n runs] [-w warmup] [-l label ...] [-k] command [arg ...] [:: command [arg ...] ...]\n"
+
+// a perf event counted for every run, until the kernel refuses it once
+struct counter
+{
+  uint32_t type;
+  uint64_t config;
+  bool     kernel;
+  bool     ok;
+};
+
+// what one run of the command cost
+struct run
+{
+  double   usec;
+  uint64_t count[COUNTERS];
+  long     rss;
+};
+
+static struct counter COUNTER[COUNTERS] = {
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, false, true },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, true,  true },
+  { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS,  true,  true },
+};
+
+static const struct option LONGOPTS[] = {
+  { "header", no_argument,       NULL,  'H' },
+  { "runs",   required_argument, NULL,  'n' },
+  { "warmup", required_argument, NULL,  'w' },
+  { "label",  required_argument, NULL,  'l' },
+  { "keep",   no_argument,       NULL,  'k' },
+  { NULL,     0,                 NULL,   0  }
+};
+
+// opens counter c on pid, held until pid execs and counting its threads
+// too; -1 once the kernel has refused it
+int counteropen(struct counter *c, pid_t pid)
+{
+  struct perf_event_attr attr;
+  int                    fd = -1;
+
+  if (!c->ok)
+    return -1;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.size           = sizeof(attr);
+  attr.type           = c->type;
+  attr.config         = c->config;
+  attr.disabled       = 1;
+  attr.enable_on_exec = 1;
+  attr.inherit        = 1;
+  attr.exclude_kernel = !c->kernel;
+  attr.exclude_hv     = 1;
+
+  if ((fd = (int)syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC)) < 0)
+    c->ok = false;
+
+  return fd;
+}
+
+// forks the command and holds it on a pipe until the counters are attached,
+// then lets it exec and waits for it. returns its exit status, or -1.
+int runonce(char *argv[], const bool keep, struct run *r)
+{
+  struct timespec start;
+  struct timespec stop;
+  struct rusage   ru;
+  int             fd[COUNTERS];
+  int             go[2]  = { -1, -1 };
+  int             null   = -1;
+  int             status = 0;
+  int             i      = 0;
+  pid_t           pid    = 0;
+  char            c      = 0;
+
+  if (0 != pipe2(go, O_CLOEXEC))
+    return -1;
+
+  if ((pid = fork()) < 0)
+  {
+    close(go[0]);
+    close(go[1]);
+    return -1;
+  }
+
+  if (0 == pid)
+  {
+    close(go[1]);
+    if (!keep && (null = open("/dev/null", O_WRONLY)) >= 0)
+    {
+      dup2(null, STDOUT_FILENO);
+      dup2(null, STDERR_FILENO);
+      close(null);
+    }
+    if (1 == read(go[0], &c, 1))
+      execvp(argv[0], argv);
+    _exit(127);
+  }
+
+  close(go[0]);
+  for (i = 0; i < COUNTERS; ++i)
+  {
+    fd[i] = counteropen(&COUNTER[i], pid);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (1 != write(go[1], &c, 1))
+    kill(pid, SIGKILL);
+  close(go[1]);
+  while (wait4(pid, &status, 0, &ru) < 0 && EINTR == errno)
+    ;
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+
+  r->usec = (double)(stop.tv_sec - start.tv_sec) * 1e6 + (double)(stop.tv_nsec - start.tv_nsec) / 1e3;
+  r->rss  = ru.ru_maxrss;
+
+  for (i = 0; i < COUNTERS; ++i)
+  {
+    r->count[i] = 0;
+    if (fd[i] >= 0)
+    {
+      if (sizeof(r->count[i]) != read(fd[i], &r->count[i], sizeof(r->count[i])))
+        r->count[i] = 0;
+      close(fd[i]);
+    }
+  }
+  if (!COUNTER[COUNTER_FAULTS].ok)
+  {
+    r->count[COUNTER_FAULTS] = (uint64_t)(ru.ru_minflt + ru.ru_majflt);
+  }
+
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int comparedouble(const void *a, const void *b)
+{
+  const double x = *(const double *)a;
+  const double y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+int compareuint64(const void *a, const void *b)
+{
+  const uint64_t x = *(const uint64_t *)a;
+  const uint64_t y = *(const uint64_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+// the median of counter i over the runs, as a column, or '-'
+char *median(char *dst, size_t len, const struct run *run, const int runs, const int i, const char *mark)
+{
+  uint64_t *v = NULL;
+  int       j = 0;
+
+  if (!COUNTER[i].ok && COUNTER_FAULTS != i)
+    return strcpy(dst, "-");
+  if (NULL == (v = malloc((size_t)runs * sizeof(*v))))
+    return strcpy(dst, "?");
+
+  for (j = 0; j < runs; ++j)
+  {
+    v[j] = run[j].count[i];
+  }
+  qsort(v, (size_t)runs, sizeof(*v), compareuint64);
+  (void)snprintf(dst, len, "%" PRIu64 "%s", v[runs / 2], mark);
+  free(v);
+
+  return dst;
+}
+
+int main(int argc, char *argv[])
+{
+  struct run   *run    = NULL;
+  double       *usec   = NULL;
+  const char  **label  = NULL;
+  char       ***cmd    = NULL;
+  char          user[24];
+  char          all[24];
+  char          faults[24];
+  long          rss    = 0;
+  int           runs   = 200;
+  int           warmup = 5;
+  int           labels = 0;
+  int           cmds   = 0;
+  int           status = 0;
+  int           i      = 0;
+  int           j      = 0;
+  int           c      = 0;
+  bool          header = false;
+  bool          keep   = false;
+
+  if (NULL == (label = calloc((size_t)argc, sizeof(*label))) || NULL == (cmd = calloc((size_t)argc, sizeof(*cmd))))
+  {
+    fprintf(stderr, "startbench: out of memory\n");
+    return 1;
+  }
+
+  while (-1 != (c = getopt_long(argc, argv, "+Hn:w:l:k", LONGOPTS, NULL)))
+  {
+    switch (c)
+    {
+      case 'H':
+        header = true;
+        break;
+
+      case 'n':
+        runs = atoi(optarg);
+        break;
+
+      case 'w':
+        warmup = atoi(optarg);
+        break;
+
+      case 'l':
+        label[labels++] = optarg;
+        break;
+
+      case 'k':
+        keep = true;
+        break;
+
+      default:
+        fprintf(stderr, USAGE);
+        return 2;
+    }
+  }
+
+  // the commands, each ended by a NULL in place of its '::'
+  for (i = optind, j = 1; i < argc; ++i)
+  {
+    if (0 == strcmp(argv[i], "::"))
+    {
+      argv[i] = NULL;
+      ++j;
+    }
+    else if (i == optind || NULL == argv[i - 1])
+    {
+      cmd[cmds++] = argv + i;
+    }
+  }
+
+  if (optind >= argc || cmds != j || labels > cmds || runs < 1 || warmup < 0)
+  {
+    fprintf(stderr, USAGE);
+    return 2;
+  }
+  for (i = labels; i < cmds; ++i)
+  {
+    label[i] = cmd[i][0];
+  }
+
+  if (NULL == (run = calloc((size_t)cmds * (size_t)runs, sizeof(*run))) || NULL == (usec = calloc((size_t)runs, sizeof(*usec))))
+  {
+    fprintf(stderr, "startbench: out of memory\n");
+    return 1;
+  }
+
+  for (i = 0; i < warmup + runs; ++i)
+  {
+    for (j = 0; j < cmds; ++j)
+    {
+      if ((status = runonce(cmd[j], keep, &run[j * runs + (i < warmup ? 0 : i - warmup)])) < 0 || 127 == status)
+      {
+        fprintf(stderr, "startbench: could not run %s\n", cmd[j][0]);
+        return 1;
+      }
+    }
+  }
+
+  if (header)
+  {
+    printf("%-24s %11s %11s %12s %12s %8s %8s\n", "", "wall us", "p90 us", "instr user", "instr all", "faults", "rss KiB");
+  }
+  for (j = 0; j < cmds; ++j)
+  {
+    rss = 0;
+    for (i = 0; i < runs; ++i)
+    {
+      usec[i] = run[j * runs + i].usec;
+      rss     = run[j * runs + i].rss > rss ? run[j * runs + i].rss : rss;
+    }
+    qsort(usec, (size_t)runs, sizeof(*usec), comparedouble);
+
+    printf("%-24s %11.1f %11.1f %12s %12s %8s %8ld\n", label[j],
+      usec[runs / 2], usec[(runs * 9) / 10],
+      median(user, sizeof(user), run + j * runs, runs, COUNTER_USER, ""),
+      median(all, sizeof(all), run + j * runs, runs, COUNTER_ALL, ""),
+      median(faults, sizeof(faults), run + j * runs, runs, COUNTER_FAULTS, COUNTER[COUNTER_FAULTS].ok ? "" : "*"),
+      rss);
+  }
+
+  free(usec);
+  free(run);
+  free(cmd);
+  free(label);
+
+  return 0;
+}
@@ -0,0 +1,675 @@
+//
+// hashes files in parallel and prints a log line for each, in argument order,
+// in the format the sysbackup scripts record:
+//
+//   [backup]file=/backup/x.tbz;md5=d41d8cd98f00b204e9800998ecf8427e;
+//
+// files are hashed concurrently on a pool of threads. MD5 is sequential within
+// a file, so a single large file still takes one core; the tree hash (xxt, an
+// XXH64 over the XXH64 digests of 4 MiB leaves) splits every file into leaves
+// that are hashed in parallel. files are read through mmap() with readahead
+// hints a window ahead of the hashing.
+//
+//   build: gcc -std=gnu99 -O2 -o sumlog sumlog.c -pthread
+//
+// usage: sumlog [-t tag] [-a md5|tree|all] [-j threads] file...
+//   -t, --tag     - tag in the log line brackets (default: backup)
+//   -a, --hash    - md5 (default), tree for the xxt tree hash only, or all
+//   -j, --jobs    - number of hashing threads (default: CPUs available)
+//
+// unreadable files, and files truncated while they are hashed, are reported
+// on stderr and make the exit status 1, but do not stop the others.
+//
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <pthread.h>
+#include <signal.h>
+#include <setjmp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// bytes of each tree hash leaf
+#define TREE_LEAF (4UL << 20)
+
+// bytes hashed between readahead hints
+#define READ_WINDOW (8UL << 20)
+
+#define HASH_MD5  0x1
+#define HASH_TREE 0x2
+
+#define TASK_MD5  0
+#define TASK_LEAF 1
+
+// a file being hashed
+struct file
+{
+  const char    *path;
+  const uint8_t *map;
+  size_t         size;
+  size_t         leaves;
+  uint64_t      *leaf;
+  size_t         pending; // tasks not yet finished
+  bool           done;
+  bool           failed;
+  bool           truncated; // shrank under the mapping while hashed
+  uint8_t        md5[16];
+  uint64_t       tree;
+};
+
+// one unit of work: the MD5 of a whole file, or one leaf of its tree hash
+struct task
+{
+  struct file *file;
+  size_t       leaf;
+  int          kind;
+};
+
+// the shared work list; threads claim tasks by bumping next
+struct pool
+{
+  struct task     *task;
+  size_t           tasks;
+  size_t           next;
+  pthread_mutex_t  lock;
+  pthread_cond_t   finished;
+};
+
+static const struct option LONGOPTS[] = {
+  { "tag",      required_argument, NULL,  't' },
+  { "hash",     required_argument, NULL,  'a' },
+  { "jobs",     required_argument, NULL,  'j' },
+  { NULL,       0,                 NULL,   0  }
+};
+
+// ----------------------------------------------------------------------------
+//  MD5 (RFC 1321)
+// ----------------------------------------------------------------------------
+
+struct md5
+{
+  uint32_t state[4];
+  uint64_t length;
+  uint8_t  block[64];
+  size_t   used;
+};
+
+static const uint32_t MD5_K[64] = {
+  0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+  0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+  0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+  0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+  0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+  0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+  0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+  0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static const uint8_t MD5_S[64] = {
+  7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+  5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+  4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+  6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+void md5init(struct md5 *m)
+{
+  m->state[0] = 0x67452301;
+  m->state[1] = 0xefcdab89;
+  m->state[2] = 0x98badcfe;
+  m->state[3] = 0x10325476;
+  m->length   = 0;
+  m->used     = 0;
+}
+
+// runs the compression function over whole 64-byte blocks
+void md5blocks(uint32_t state[4], const uint8_t *p, size_t blocks)
+{
+  uint32_t w[16];
+  uint32_t a = 0;
+  uint32_t b = 0;
+  uint32_t c = 0;
+  uint32_t d = 0;
+  uint32_t f = 0;
+  uint32_t t = 0;
+  int      g = 0;
+  int      i = 0;
+
+  for (; blocks > 0; --blocks, p += 64)
+  {
+    for (i = 0; i < 16; ++i)
+    {
+      w[i] = (uint32_t)p[4 * i] | (uint32_t)p[4 * i + 1] << 8 | (uint32_t)p[4 * i + 2] << 16 | (uint32_t)p[4 * i + 3] << 24;
+    }
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+
+    for (i = 0; i < 64; ++i)
+    {
+      switch (i >> 4)
+      {
+        case 0:  f = (b & c) | (~b & d); g = i;               break;
+        case 1:  f = (d & b) | (~d & c); g = (5 * i + 1) & 15; break;
+        case 2:  f = b ^ c ^ d;          g = (3 * i + 5) & 15; break;
+        default: f = c ^ (b | ~d);       g = (7 * i) & 15;     break;
+      }
+      t = d;
+      d = c;
+      c = b;
+      b = b + ROTL32(a + f + MD5_K[i] + w[g], MD5_S[i]);
+      a = t;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+  }
+}
+
+void md5update(struct md5 *m, const uint8_t *p, size_t len)
+{
+  size_t n = 0;
+
+  m->length += len;
+
+  if (m->used > 0)
+  {
+    n = 64 - m->used < len ? 64 - m->used : len;
+    memcpy(m->block + m->used, p, n);
+    m->used += n;
+    p       += n;
+    len     -= n;
+    if (64 > m->used)
+      return;
+    md5blocks(m->state, m->block, 1);
+    m->used = 0;
+  }
+
+  md5blocks(m->state, p, len / 64);
+  p   += len & ~(size_t)63;
+  len &= 63;
+
+  memcpy(m->block, p, len);
+  m->used = len;
+}
+
+void md5final(struct md5 *m, uint8_t digest[16])
+{
+  uint64_t bits = m->length * 8;
+  int      i    = 0;
+
+  m->block[m->used++] = 0x80;
+  if (m->used > 56)
+  {
+    memset(m->block + m->used, 0, 64 - m->used);
+    md5blocks(m->state, m->block, 1);
+    m->used = 0;
+  }
+  memset(m->block + m->used, 0, 56 - m->used);
+  for (i = 0; i < 8; ++i)
+  {
+    m->block[56 + i] = (uint8_t)(bits >> (8 * i));
+  }
+  md5blocks(m->state, m->block, 1);
+
+  for (i = 0; i < 16; ++i)
+  {
+    digest[i] = (uint8_t)(m->state[i / 4] >> (8 * (i % 4)));
+  }
+}
+
+// ----------------------------------------------------------------------------
+//  XXH64
+// ----------------------------------------------------------------------------
+
+#define XXH_P1 11400714785074694791ULL
+#define XXH_P2 14029467366897019727ULL
+#define XXH_P3  1609587929392839161ULL
+#define XXH_P4  9650029242287828579ULL
+#define XXH_P5  2870177450012600261ULL
+
+#define ROTL64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+static inline uint64_t read64(const uint8_t *p)
+{
+  uint64_t v;
+
+  memcpy(&v, p, sizeof(v));
+
+  return v;
+}
+
+static inline uint32_t read32(const uint8_t *p)
+{
+  uint32_t v;
+
+  memcpy(&v, p, sizeof(v));
+
+  return v;
+}
+
+static inline uint64_t xxhround(uint64_t acc, const uint64_t in)
+{
+  acc += in * XXH_P2;
+  acc  = ROTL64(acc, 31);
+
+  return acc * XXH_P1;
+}
+
+static inline uint64_t xxhmerge(uint64_t acc, const uint64_t v)
+{
+  acc ^= xxhround(0, v);
+
+  return acc * XXH_P1 + XXH_P4;
+}
+
+// XXH64 of len bytes at p (little-endian hosts)
+uint64_t xxh64(const uint8_t *p, size_t len, const uint64_t seed)
+{
+  const uint8_t *end = p + len;
+  uint64_t       v1  = seed + XXH_P1 + XXH_P2;
+  uint64_t       v2  = seed + XXH_P2;
+  uint64_t       v3  = seed;
+  uint64_t       v4  = seed - XXH_P1;
+  uint64_t       h   = 0;
+
+  if (len >= 32)
+  {
+    for (; p + 32 <= end; p += 32)
+    {
+      v1 = xxhround(v1, read64(p));
+      v2 = xxhround(v2, read64(p + 8));
+      v3 = xxhround(v3, read64(p + 16));
+      v4 = xxhround(v4, read64(p + 24));
+    }
+    h = ROTL64(v1, 1) + ROTL64(v2, 7) + ROTL64(v3, 12) + ROTL64(v4, 18);
+    h = xxhmerge(h, v1);
+    h = xxhmerge(h, v2);
+    h = xxhmerge(h, v3);
+    h = xxhmerge(h, v4);
+  }
+  else
+  {
+    h = seed + XXH_P5;
+  }
+
+  h += (uint64_t)len;
+
+  for (; p + 8 <= end; p += 8)
+  {
+    h ^= xxhround(0, read64(p));
+    h  = ROTL64(h, 27) * XXH_P1 + XXH_P4;
+  }
+  if (p + 4 <= end)
+  {
+    h ^= (uint64_t)read32(p) * XXH_P1;
+    h  = ROTL64(h, 23) * XXH_P2 + XXH_P3;
+    p += 4;
+  }
+  for (; p < end; ++p)
+  {
+    h ^= *p * XXH_P5;
+    h  = ROTL64(h, 11) * XXH_P1;
+  }
+
+  h ^= h >> 33;
+  h *= XXH_P2;
+  h ^= h >> 29;
+  h *= XXH_P3;
+  h ^= h >> 32;
+
+  return h;
+}
+
+// ----------------------------------------------------------------------------
+//  hashing
+// ----------------------------------------------------------------------------
+
+// where a worker resumes when the file it reads is truncated by another
+// process: touching mapped pages past the new end raises SIGBUS
+static __thread sigjmp_buf *BUSJUMP;
+
+void onbus(int sig)
+{
+  if (NULL != BUSJUMP)
+    siglongjmp(*BUSJUMP, 1);
+
+  (void)signal(sig, SIG_DFL);
+  (void)raise(sig);
+}
+
+// hints the kernel to read the window after the one at 'at' while it is hashed
+void prefetch(const struct file *f, const size_t at)
+{
+  size_t next = at + READ_WINDOW;
+
+  if (next < f->size)
+  {
+    (void)madvise((void *)(f->map + next), f->size - next < READ_WINDOW ? f->size - next : READ_WINDOW, MADV_WILLNEED);
+  }
+}
+
+void hashmd5(struct file *f)
+{
+  struct md5 m;
+  size_t     at  = 0;
+  size_t     len = 0;
+
+  md5init(&m);
+  for (at = 0; at < f->size; at += len)
+  {
+    len = f->size - at < READ_WINDOW ? f->size - at : READ_WINDOW;
+    prefetch(f, at);
+    md5update(&m, f->map + at, len);
+  }
+  md5final(&m, f->md5);
+}
+
+void hashleaf(struct file *f, const size_t leaf)
+{
+  size_t at  = leaf * TREE_LEAF;
+  size_t len = f->size - at < TREE_LEAF ? f->size - at : TREE_LEAF;
+
+  if (0 == f->size)
+    len = 0;
+  else
+    (void)madvise((void *)(f->map + at), len, MADV_WILLNEED);
+
+  f->leaf[leaf] = xxh64(f->map + at, len, 0);
+}
+
+// the root of the tree hash: XXH64 over the little-endian leaf digests, seeded
+// with the file size so that files of different lengths never share a root
+void hashtree(struct file *f)
+{
+  f->tree = xxh64((const uint8_t *)f->leaf, f->leaves * sizeof(*f->leaf), (uint64_t)f->size);
+}
+
+void *worker(void *arg)
+{
+  struct pool *pool = arg;
+  struct task *task = NULL;
+  struct file *f    = NULL;
+  sigjmp_buf   jump;
+  size_t       i    = 0;
+
+  while ((i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->tasks)
+  {
+    task = &pool->task[i];
+    f    = task->file;
+
+    // the handler runs with SA_NODEFER, so the signal mask needs no restoring
+    if (0 == sigsetjmp(jump, 0))
+    {
+      BUSJUMP = &jump;
+      if (TASK_MD5 == task->kind)
+        hashmd5(f);
+      else
+        hashleaf(f, task->leaf);
+    }
+    else
+    {
+      __atomic_store_n(&f->truncated, true, __ATOMIC_RELAXED);
+    }
+    BUSJUMP = NULL;
+
+    if (1 == __atomic_fetch_sub(&f->pending, 1, __ATOMIC_ACQ_REL))
+    {
+      if (f->leaves > 0)
+        hashtree(f);
+      (void)pthread_mutex_lock(&pool->lock);
+      f->done = true;
+      (void)pthread_cond_broadcast(&pool->finished);
+      (void)pthread_mutex_unlock(&pool->lock);
+    }
+  }
+
+  return NULL;
+}
+
+// maps a file and counts the tasks it needs; false if it cannot be read
+bool openfile(struct file *f, const int hash)
+{
+  struct stat st;
+  int         fd = -1;
+
+  if ((fd = open(f->path, O_RDONLY | O_CLOEXEC)) < 0 || 0 != fstat(fd, &st))
+    goto fail;
+  if (!S_ISREG(st.st_mode))
+  {
+    errno = S_ISDIR(st.st_mode) ? EISDIR : EINVAL;
+    goto fail;
+  }
+
+  f->size = (size_t)st.st_size;
+  if (f->size > 0)
+  {
+    f->map = mmap(NULL, f->size, PROT_READ, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == f->map)
+    {
+      f->map = NULL;
+      goto fail;
+    }
+    (void)madvise((void *)f->map, f->size, HASH_TREE == hash ? MADV_NORMAL : MADV_SEQUENTIAL);
+    (void)madvise((void *)f->map, f->size < READ_WINDOW ? f->size : READ_WINDOW, MADV_WILLNEED);
+  }
+  (void)close(fd);
+  fd = -1;
+
+  if (hash & HASH_TREE)
+  {
+    f->leaves = f->size > 0 ? (f->size + TREE_LEAF - 1) / TREE_LEAF : 1;
+    if (NULL == (f->leaf = calloc(f->leaves, sizeof(*f->leaf))))
+      goto fail;
+  }
+  f->pending = (hash & HASH_MD5 ? 1 : 0) + f->leaves;
+
+  return true;
+
+fail:
+  fprintf(stderr, "sumlog: %s: %s\n", f->path, strerror(errno));
+  if (fd >= 0)
+    (void)close(fd);
+  if (NULL != f->map)
+    (void)munmap((void *)f->map, f->size);
+  f->map    = NULL;
+  f->failed = true;
+  f->done   = true;
+
+  return false;
+}
+
+void printline(const struct file *f, const char *tag, const int hash)
+{
+  int i = 0;
+
+  printf("[%s]file=%s;", tag, f->path);
+  if (hash & HASH_MD5)
+  {
+    printf("md5=");
+    for (i = 0; i < 16; ++i)
+    {
+      printf("%02x", f->md5[i]);
+    }
+    printf(";");
+  }
+  if (hash & HASH_TREE)
+  {
+    printf("xxt=%016llx;", (unsigned long long)f->tree);
+  }
+  printf("\n");
+}
+
+int cpus()
+{
+  cpu_set_t set;
+
+  if (0 == sched_getaffinity(0, sizeof(set), &set))
+    return CPU_COUNT(&set);
+
+  return (int)sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+int main(int argc, char *argv[])
+{
+  struct pool      pool    = { NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+  struct sigaction bus;
+  struct file     *file    = NULL;
+  pthread_t       *tid     = NULL;
+  const char      *tag     = "backup";
+  size_t           files   = 0;
+  size_t           i       = 0;
+  size_t           l       = 0;
+  int              hash    = HASH_MD5;
+  int              threads = cpus();
+  int              started = 0;
+  int              status  = 0;
+  int              c       = 0;
+
+  while (-1 != (c = getopt_long(argc, argv, "t:a:j:", LONGOPTS, NULL)))
+  {
+    switch (c)
+    {
+      case 't':
+        tag = optarg;
+        break;
+
+      case 'a':
+        if (0 == strcmp(optarg, "md5"))
+          hash = HASH_MD5;
+        else if (0 == strcmp(optarg, "tree"))
+          hash = HASH_TREE;
+        else if (0 == strcmp(optarg, "all"))
+          hash = HASH_MD5 | HASH_TREE;
+        else
+        {
+          fprintf(stderr, "sumlog: unknown --hash '%s' (md5, tree, all)\n", optarg);
+          return 2;
+        }
+        break;
+
+      case 'j':
+        threads = atoi(optarg);
+        break;
+
+      default:
+        fprintf(stderr, "usage: sumlog [-t tag] [-a md5|tree|all] [-j threads] file...\n");
+        return 2;
+    }
+  }
+
+  files = (size_t)(argc - optind);
+  if (0 == files)
+  {
+    return 0;
+  }
+  if (threads < 1)
+  {
+    threads = 1;
+  }
+
+  memset(&bus, 0, sizeof(bus));
+  bus.sa_handler = onbus;
+  bus.sa_flags   = SA_NODEFER;
+  (void)sigaction(SIGBUS, &bus, NULL);
+
+  if (NULL == (file = calloc(files, sizeof(*file))))
+  {
+    perror("calloc");
+    return 1;
+  }
+
+  for (i = 0; i < files; ++i)
+  {
+    file[i].path = argv[optind + i];
+    if (openfile(&file[i], hash))
+      pool.tasks += file[i].pending;
+    else
+      status = 1;
+  }
+
+  // in argument order, each MD5 ahead of the leaves of its file, so that the
+  // longest sequential jobs start first and lines can be printed early
+  if (NULL == (pool.task = calloc(pool.tasks > 0 ? pool.tasks : 1, sizeof(*pool.task))))
+  {
+    perror("calloc");
+    return 1;
+  }
+  for (i = 0, pool.tasks = 0; i < files; ++i)
+  {
+    if (file[i].failed)
+      continue;
+    if (hash & HASH_MD5)
+      pool.task[pool.tasks++] = (struct task){ &file[i], 0, TASK_MD5 };
+    for (l = 0; l < file[i].leaves; ++l)
+      pool.task[pool.tasks++] = (struct task){ &file[i], l, TASK_LEAF };
+  }
+
+  if ((size_t)threads > pool.tasks)
+  {
+    threads = pool.tasks > 0 ? (int)pool.tasks : 1;
+  }
+  if (NULL == (tid = calloc((size_t)threads, sizeof(*tid))))
+  {
+    perror("calloc");
+    return 1;
+  }
+  for (started = 0; started < threads; ++started)
+  {
+    if (0 != pthread_create(&tid[started], NULL, worker, &pool))
+      break;
+  }
+  if (0 == started)
+  {
+    (void)worker(&pool);
+  }
+
+  for (i = 0; i < files; ++i)
+  {
+    (void)pthread_mutex_lock(&pool.lock);
+    while (!file[i].done)
+      (void)pthread_cond_wait(&pool.finished, &pool.lock);
+    (void)pthread_mutex_unlock(&pool.lock);
+
+    if (file[i].truncated)
+    {
+      fprintf(stderr, "sumlog: %s: file was truncated while it was hashed\n", file[i].path);
+      status = 1;
+    }
+    else if (!file[i].failed)
+    {
+      printline(&file[i], tag, hash);
+      (void)fflush(stdout);
+    }
+    if (NULL != file[i].map)
+      (void)munmap((void *)file[i].map, file[i].size);
+    free(file[i].leaf);
+  }
+
+  while (started > 0)
+  {
+    (void)pthread_join(tid[--started], NULL);
+  }
+
+  free(tid);
+  free(pool.task);
+  free(file);
+
+  return status;
+}
@@ -10,6 +10,7 @@ exclude=/backup/exclude.files
 lastbup=/backup/backup.log
 lockbup=/backup/.backup.lock
 rotates=/backup/rotate.sh
+sumlogs=/backup/sumlog # native hasher, see C/sumlog.c
 
 # comment out to actually perform backup
 #rsyncdryrun=--dry-run
@@ -34,7 +35,12 @@ function logline
     file=$1
     if [[ -f "${file}" ]]
     then
-      echo "[backup]file=${file};md5="$( md5sum "${file}" | \grep -oP '^\S+' )";"
+      if [[ -x "${sumlogs}" ]]
+      then
+        "${sumlogs}" -t backup "${file}"
+      else
+        echo "[backup]file=${file};md5="$( md5sum "${file}" | \grep -oP '^\S+' )";"
+      fi
     fi
   fi
 }
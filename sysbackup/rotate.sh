@@ -15,6 +15,8 @@ DEBUG=0
 
 lastbup=/backup/backup.log
 lockbup=/backup/.backup.lock
+sumlogs=/backup/sumlog # native hasher, see C/sumlog.c
+retains=/backup/retain # native planner, see C/retain.c
 
 weekly_dow="Sunday"
 weekly_kept=4
@@ -24,10 +26,18 @@ function logline
 {
   if [[ $# -gt 0 ]]
   then
-    file=$1
-    if [[ -f "${file}" ]]
+    if [[ -x "${sumlogs}" ]]
     then
-      echo "[rotate]file=${file};md5="$( md5sum "${file}" | \grep -oP '^\S+' )";"
+      # hashes all of the files at once, in parallel
+      "${sumlogs}" -t rotate "$@"
+    else
+      for file in "$@"
+      do
+        if [[ -f "${file}" ]]
+        then
+          echo "[rotate]file=${file};md5="$( md5sum "${file}" | \grep -oP '^\S+' )";"
+        fi
+      done
     fi
   fi
 }
@@ -65,103 +75,133 @@ then
             | tr ' ' '_' )
 
   # ---------------------------------------------------------------------------
-  # build a list of filenames we should keep
+  # remove the files none of the schemes protects
   # ---------------------------------------------------------------------------
 
-  keep=()
-  daily=()
-  weekly=()
-  monthly=()
-
-  recent_weekly=
-
-  # keep all backups within the last 7 days (including today)
-  for day in 0 1 2 3 4 5 6
-  do
-
-    _date=$( date -d "${datetime} -${day} days" )
-    _day=$( date -d "${_date}" "+%A" )
-    _name="${oskernel}__"$( date -d "${_date}" "+%Y-%m-%d__" )
+  if [[ -x "${retains}" ]]
+  then
 
-    [[ "${weekly_dow}" == "${_day}" ]] && recent_weekly="${_date}"
+    retainopts=( -p "${oskernel}" -d "$( date -d "${datetime}" "+%Y-%m-%d" )" \
+                 -W ${weekly_kept} -M ${monthly_kept} -w ${weekly_dow} )
 
-    daily+=( "${_name}" )
+    mapfile -t doomed < <( "${retains}" "${retainopts[@]}" "${source}" )
 
-  done
+    if [[ ${#doomed[@]} -gt 0 ]]
+    then
+      logline "${doomed[@]}" >> "${lastbup}"
+      printf "rm -f '%s'\n" "${doomed[@]}"
+      rm -f -- "${doomed[@]}"
+    fi
 
-  # keep all weekly backups for the last N weeks (including this week)
-  for week in $( seq 0 $(( weekly_kept - 1 )) )
-  do
+    # the planner prints its keep-set on stderr, apart from the list above;
+    # show it on stdout after the removals, as the loops below do
+    if [[ -n ${DEBUG} ]] && [[ ${DEBUG} != "0" ]]
+    then
+      "${retains}" "${retainopts[@]}" -v "${source}" 2>&1 > /dev/null
+    fi
 
-    _date=$( date -d "${recent_weekly} -${week} weeks" )
-    _name="${oskernel}__"$( date -d "${_date}" "+%Y-%m-%d__" )
+  else
 
-    weekly+=( "${_name}" )
+    # -------------------------------------------------------------------------
+    # build a list of filenames we should keep
+    # -------------------------------------------------------------------------
 
-  done
+    keep=()
+    daily=()
+    weekly=()
+    monthly=()
 
-  day_of_month=$( date -d "${datetime}" "+%d" )
-  first_of_month=$( date -d "${datetime} -$(( day_of_month - 1 )) days" )
+    recent_weekly=
 
-  # keep all monthly backups for the last N months (including this month)
-  for month in $( seq 0 $(( monthly_kept - 1 )) )
-  do
+    # keep all backups within the last 7 days (including today)
+    for day in 0 1 2 3 4 5 6
+    do
 
-    _date=$( date -d "${first_of_month} -${month} months" )
-    _name="${oskernel}__"$( date -d "${_date}" "+%Y-%m-%d__" )
+      _date=$( date -d "${datetime} -${day} days" )
+      _day=$( date -d "${_date}" "+%A" )
+      _name="${oskernel}__"$( date -d "${_date}" "+%Y-%m-%d__" )
 
-    monthly+=( "${_name}" )
-    
-  done
+      [[ "${weekly_dow}" == "${_day}" ]] && recent_weekly="${_date}"
 
-  keep=( "${daily[@]}" "${weekly[@]}" "${monthly[@]}" )
+      daily+=( "${_name}" )
 
-  keep_file()
-  {
-    for curr in "${keep[@]}"; do [[ "${name}" =~ ^"${curr}" ]] && return 0; done
-    return 1
-  }
+    done
 
-  find "${source}" -maxdepth 1 -iname "*.tbz" -print | \
-    while read -re path
+    # keep all weekly backups for the last N weeks (including this week)
+    for week in $( seq 0 $(( weekly_kept - 1 )) )
     do
 
-      name=$( basename "${path}" )
+      _date=$( date -d "${recent_weekly} -${week} weeks" )
+      _name="${oskernel}__"$( date -d "${_date}" "+%Y-%m-%d__" )
 
-      if ! keep_file "${name}"
-      then 
-        logline "${path}" >> "${lastbup}"
-        echo "rm -f '${path}'"
-        rm -f "${path}"
-      fi
+      weekly+=( "${_name}" )
 
     done
 
-  if [[ -n ${DEBUG} ]] && [[ ${DEBUG} != "0" ]]
-  then
-    echo "daily:"
-    for name in "${daily[@]}"
-    do
-      echo "  ${name}"
-    done
+    day_of_month=$( date -d "${datetime}" "+%d" )
+    first_of_month=$( date -d "${datetime} -$(( 10#${day_of_month} - 1 )) days" )
 
-    echo "weekly:"
-    for name in "${weekly[@]}"
+    # keep all monthly backups for the last N months (including this month)
+    for month in $( seq 0 $(( monthly_kept - 1 )) )
     do
-      echo "  ${name}"
-    done
 
-    echo "monthly:"
-    for name in "${monthly[@]}"
-    do
-      echo "  ${name}"
-    done
+      _date=$( date -d "${first_of_month} -${month} months" )
+      _name="${oskernel}__"$( date -d "${_date}" "+%Y-%m-%d__" )
 
-    echo "all:"
-    for name in "${keep[@]}"
-    do
-      echo "  ${name}"
+      monthly+=( "${_name}" )
+    
     done
+
+    keep=( "${daily[@]}" "${weekly[@]}" "${monthly[@]}" )
+
+    keep_file()
+    {
+      for curr in "${keep[@]}"; do [[ "${name}" =~ ^"${curr}" ]] && return 0; done
+      return 1
+    }
+
+    find "${source}" -maxdepth 1 -iname "*.tbz" -print | \
+      while read -re path
+      do
+
+        name=$( basename "${path}" )
+
+        if ! keep_file "${name}"
+        then 
+          logline "${path}" >> "${lastbup}"
+          echo "rm -f '${path}'"
+          rm -f "${path}"
+        fi
+
+      done
+
+    if [[ -n ${DEBUG} ]] && [[ ${DEBUG} != "0" ]]
+    then
+      echo "daily:"
+      for name in "${daily[@]}"
+      do
+        echo "  ${name}"
+      done
+
+      echo "weekly:"
+      for name in "${weekly[@]}"
+      do
+        echo "  ${name}"
+      done
+
+      echo "monthly:"
+      for name in "${monthly[@]}"
+      do
+        echo "  ${name}"
+      done
+
+      echo "all:"
+      for name in "${keep[@]}"
+      do
+        echo "  ${name}"
+      done
+    fi
+
   fi
 
 else